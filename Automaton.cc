@@ -1,91 +1,507 @@
 #include "Automaton.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AUTOMATON_X86_KERNELS
+#endif
+
 namespace fa {
+  namespace {
+    // Approximate size of the node of a std::map, std::unordered_map or std::set, without its value
+    constexpr std::size_t NodeOverhead = 4 * sizeof(void*);
+
+    // A state costs its number, its vector of transitions and its node in the index of the numbers
+    constexpr std::size_t StateBytes = sizeof(int) + 3 * sizeof(void*) + sizeof(std::pair<const int, int>) + NodeOverhead;
+    // A transition is a letter and a target index in the vector of its origin state
+    constexpr std::size_t ArcBytes = 2 * sizeof(int);
+
+    // Statistics of the innermost StatisticsScope of the thread, or null if there is none
+    thread_local Statistics* activeStatistics = nullptr;
+    // Number of measured operations in progress on the thread
+    thread_local int measureDepth = 0;
+
+    /**
+     * @brief Count an operation and its wall time in the active statistics, if it is the outermost one
+     * (Used for the determinizations, the products, the minimizations and the inclusion and equivalence tests)
+     */
+    class Measure{
+    public:
+      Measure()
+      : statistics(activeStatistics), outermost(false)
+      {
+        if(statistics != nullptr){
+          outermost = measureDepth++ == 0;
+          if(outermost){
+            start = std::chrono::steady_clock::now();
+          }
+        }
+      }
+
+      ~Measure(){
+        if(statistics != nullptr){
+          measureDepth--;
+          if(outermost){
+            statistics->operations++;
+            statistics->wallTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+          }
+        }
+      }
+
+      Measure(const Measure&) = delete;
+      Measure& operator=(const Measure&) = delete;
+
+      /**
+       * @brief Give the statistics to fill, or null if they aren't collected
+       */
+      Statistics* get() const{
+        return statistics;
+      }
+
+    private:
+      Statistics* statistics;
+      bool outermost;
+      std::chrono::steady_clock::time_point start;
+    };
+
+    /**
+     * @brief Keeps track of the resources used by a transformation, and throws LimitExceeded when one of the limits is exceeded
+     * (Used for createDeterministic(), createDeterministicParallel(), createProduct() and createMinimalMoore())
+     * The counters are atomic, so the same budget can be shared by several threads.
+     */
+    class Budget{
+    public:
+      explicit Budget(const Limits& limits)
+      : limits(limits), statistics(activeStatistics), states(0), transitions(0), bytes(0)
+      {
+      }
+
+      /**
+       * @brief Add the created states and transitions to the active statistics
+       */
+      ~Budget(){
+        if(statistics != nullptr){
+          statistics->statesExplored += states;
+          statistics->transitionsExplored += transitions;
+          statistics->peakBytes = std::max<std::size_t>(statistics->peakBytes, bytes);
+        }
+      }
+
+      /**
+       * @brief Count a new state and the memory it uses
+       */
+      void addState(std::size_t stateBytes){
+        std::size_t created = ++states;
+        addBytes(stateBytes);
+        if(limits.maxStates != 0 && created > limits.maxStates){
+          throw LimitExceeded(LimitExceeded::Reason::States, created);
+        }
+        if(created % 256 == 0){
+          poll();
+        }
+      }
+
+      /**
+       * @brief Count memory used by something else than a state, like a transition
+       */
+      void addBytes(std::size_t moreBytes){
+        if(limits.maxBytes != 0){
+          if((bytes += moreBytes) > limits.maxBytes){
+            throw LimitExceeded(LimitExceeded::Reason::Bytes, states);
+          }
+        }else if(statistics != nullptr){
+          bytes += moreBytes;
+        }
+      }
+
+      /**
+       * @brief Count a new transition and the memory it uses
+       */
+      void addTransition(){
+        if(statistics != nullptr){
+          transitions++;
+        }
+        addBytes(ArcBytes);
+      }
+
+      /**
+       * @brief Check a result found in a cache against the limits, as if its states and transitions had been created
+       */
+      void admit(std::size_t resultStates, std::size_t resultTransitions) const{
+        if(limits.maxStates != 0 && resultStates > limits.maxStates){
+          throw LimitExceeded(LimitExceeded::Reason::States, resultStates);
+        }
+        if(limits.maxBytes != 0 && resultStates * StateBytes + resultTransitions * ArcBytes > limits.maxBytes){
+          throw LimitExceeded(LimitExceeded::Reason::Bytes, resultStates);
+        }
+        poll();
+      }
+
+      /**
+       * @brief Check the cancellation flag and the deadline, and report the progress
+       */
+      void poll() const{
+        if(limits.cancelled != nullptr && limits.cancelled->load(std::memory_order_relaxed)){
+          throw LimitExceeded(LimitExceeded::Reason::Cancelled, states);
+        }
+        if(limits.deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() > limits.deadline){
+          throw LimitExceeded(LimitExceeded::Reason::Deadline, states);
+        }
+        if(limits.progress){
+          std::lock_guard<std::mutex> lock(progressMutex);
+          limits.progress(states);
+        }
+      }
+
+    private:
+      const Limits& limits;
+      Statistics* statistics;
+      std::atomic<std::size_t> states;
+      std::atomic<std::size_t> transitions;
+      std::atomic<std::size_t> bytes;
+      mutable std::mutex progressMutex;
+    };
+
+    /**
+     * @brief Threads started once, that share the ranges given to parallelFor() until the pool is destroyed
+     * (Used for createMinimalMooreParallel())
+     */
+    class WorkerPool{
+    public:
+      using Function = std::function<void(std::size_t begin, std::size_t end)>;
+
+      /**
+       * @brief Start the workers, the calling thread being the first of the threads
+       */
+      explicit WorkerPool(std::size_t threads)
+      : threads(std::max<std::size_t>(1, threads)), function(nullptr), count(0), generation(0), pending(0), stopping(false)
+      {
+        for(std::size_t worker = 1; worker < this->threads; worker++){
+          workers.emplace_back(&WorkerPool::work, this, worker);
+        }
+      }
+
+      ~WorkerPool(){
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          stopping = true;
+        }
+        started.notify_all();
+        for(auto &worker : workers){
+          worker.join();
+        }
+      }
+
+      /**
+       * @brief Give the length of the chunks of a range, the chunk of the thread t being [t * chunk, (t + 1) * chunk)
+       */
+      std::size_t chunkSize(std::size_t rangeCount) const{
+        return std::max<std::size_t>(1, (rangeCount + threads - 1) / threads);
+      }
+
+      /**
+       * @brief Split the range [0, rangeCount) in one chunk per thread, and call the function on each chunk, returning when they are all done
+       */
+      void parallelFor(std::size_t rangeCount, const Function& rangeFunction){
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          function = &rangeFunction;
+          count = rangeCount;
+          pending = workers.size();
+          generation++;
+        }
+        started.notify_all();
+        runChunk(0, rangeCount, rangeFunction);
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this]{
+          return pending == 0;
+        });
+      }
+
+    private:
+      std::size_t threads;
+      std::vector<std::thread> workers;
+      std::mutex mutex;
+      std::condition_variable started;
+      std::condition_variable finished;
+      const Function* function;
+      std::size_t count;
+      std::size_t generation; // Increased by each call to parallelFor()
+      std::size_t pending; // Workers that have not finished their chunk yet
+      bool stopping;
+
+      void runChunk(std::size_t worker, std::size_t rangeCount, const Function& rangeFunction) const{
+        std::size_t chunk = chunkSize(rangeCount);
+        std::size_t begin = worker * chunk;
+        if(begin < rangeCount){
+          rangeFunction(begin, std::min(begin + chunk, rangeCount));
+        }
+      }
+
+      void work(std::size_t worker){
+        std::size_t done = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for(;;){
+          started.wait(lock, [&]{
+            return stopping || generation != done;
+          });
+          if(stopping){
+            return;
+          }
+          done = generation;
+          const Function& rangeFunction = *function;
+          std::size_t rangeCount = count;
+          lock.unlock();
+          runChunk(worker, rangeCount, rangeFunction);
+          lock.lock();
+          if(--pending == 0){
+            finished.notify_one();
+          }
+        }
+      }
+    };
+
+    /**
+     * @brief Hash a sequence of states
+     * (Used for createProduct() and createDeterministicParallel())
+     */
+    std::size_t hashStates(const int* states, std::size_t count){
+      std::uint64_t h = 14695981039346656037ULL;
+      for(std::size_t i = 0; i < count; i++){
+        h ^= (std::uint32_t)states[i];
+        h *= 1099511628211ULL;
+        h ^= h >> 29;
+      }
+      return (std::size_t)h;
+    }
+  }
+
   /**
-   * @brief Private recursive function that runs throught the automaton trying to find a final state, begining by the initials states
-   * (Used in isLanguageEmpty())
-   * @param state the current state
-   * @param visited the set of states already visited
-   * @return true if a final state is find
-   * @return false if a final state hasn't be found
+   * @brief Private function that gives the dense index of a state
+   * 
+   * @param state the number of the state
+   * @return int the index of the state in states, or -1 if there is no such state
    */
-  bool Automaton::depthFirstSearch(int state, std::set<int> &visited) const{
-    if(isStateFinal(state)){
-      return true;
+  int Automaton::indexOf(int state) const{
+    auto search = indexes.find(state);
+    if(search == indexes.end()){
+      return -1;
     }
-    visited.insert(state);
-    for(auto const adjacent_state : map_arcs){
-      if(adjacent_state.first == state){
-        if(visited.find(adjacent_state.second.to) == visited.end()){
-          if(depthFirstSearch(adjacent_state.second.to, visited)){
-            return true;
-          }
-        }
+    return search->second;
+  }
+
+  bool Automaton::IndexSet::test(std::size_t index) const{
+    return (words[index >> 6] >> (index & 63)) & 1;
+  }
+
+  void Automaton::IndexSet::insert(std::size_t index){
+    words[index >> 6] |= std::uint64_t(1) << (index & 63);
+  }
+
+  void Automaton::IndexSet::erase(std::size_t index){
+    words[index >> 6] &= ~(std::uint64_t(1) << (index & 63));
+  }
+
+  void Automaton::IndexSet::resize(std::size_t count){
+    words.resize((count + 63) / 64, 0);
+    if(count % 64 != 0){
+      words.back() &= (std::uint64_t(1) << (count % 64)) - 1;
+    }
+  }
+
+  bool Automaton::IndexSet::any() const{
+    for(auto const word : words){
+      if(word != 0){
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool Automaton::IndexSet::intersects(const IndexSet& other) const{
+    std::size_t size = std::min(words.size(), other.words.size());
+    for(std::size_t word = 0; word < size; word++){
+      if((words[word] & other.words[word]) != 0){
+        return true;
       }
     }
     return false;
   }
 
   /**
-   * @brief Private recursive function that runs throught the automaton trying to find all states, begining by the initials states
-   * (Used for RemoveNonAssessible())
-   * @param state the current state
-   * @param visited the set of states already visited
+   * @brief Private function that adds a state which doesn't exist yet at the end of the dense storage
+   * 
+   * @param state the number of the state
+   * @param isInitial true if the state is initial
+   * @param isFinal true if the state is final
+   * @return int the index of the new state
+   */
+  int Automaton::appendState(int state, bool isInitial, bool isFinal){
+    int index = (int)values.size();
+    values.push_back(state);
+    transitions.emplace_back();
+    indexes.insert({state, index});
+    initial_states.resize(values.size());
+    final_states.resize(values.size());
+    if(isInitial){
+      setIndexInitial(index);
+    }
+    if(isFinal){
+      final_states.insert(index);
+    }
+    return index;
+  }
+
+  /**
+   * @brief Private function that adds a transition between dense indexes, without checking if it already exists
+   * 
+   * @param from the index of the state where the transition come from
+   * @param alpha by what letter the transition will go
+   * @param to the index of the state where the transition is aiming
+   */
+  void Automaton::appendTransition(int from, char alpha, int to){
+    transitions[from].push_back(Transition{alpha, to});
+    transition_count++;
+  }
+
+  /**
+   * @brief Private function that makes a state initial, keeping the list of the initial indexes sorted
+   * 
+   * @param index the index of the state
+   */
+  void Automaton::setIndexInitial(int index){
+    if(!initial_states.test(index)){
+      initial_states.insert(index);
+      initials.insert(std::lower_bound(initials.begin(), initials.end(), index), index);
+    }
+  }
+
+  /**
+   * @brief Private function that removes the states whose index isn't kept, with every transition from or to them
+   * (Used for removeState(), removeNonAccessibleStates() and removeNonCoAccessibleStates())
+   * The kept states are moved to the front, keeping their order, and the transitions are renumbered in a single pass.
+   * @param kept the indexes of the states that stay
    */
-  void Automaton::depthFirstSearch_NonAccessible(int state, std::set<int> &visited) const{
-    visited.insert(state);
-    for(auto const adjacent_state : map_arcs){
-      if(adjacent_state.first == state){
-        if(visited.find(adjacent_state.second.to) == visited.end()){
-          depthFirstSearch_NonAccessible(adjacent_state.second.to, visited);
+  void Automaton::keepIndexes(const IndexSet& kept){
+    std::vector<int> renumber(values.size(), -1);
+    IndexSet initialKept;
+    IndexSet finalKept;
+    initialKept.resize(values.size());
+    finalKept.resize(values.size());
+    int count = 0;
+    for(std::size_t index = 0; index < values.size(); index++){
+      if(kept.test(index)){
+        renumber[index] = count;
+        values[count] = values[index];
+        if(initial_states.test(index)){
+          initialKept.insert(count);
+        }
+        if(final_states.test(index)){
+          finalKept.insert(count);
+        }
+        transitions[count].swap(transitions[index]);
+        count++;
+      }else{
+        indexes.erase(values[index]);
+      }
+    }
+    values.resize(count);
+    transitions.resize(count);
+    initial_states = std::move(initialKept);
+    final_states = std::move(finalKept);
+    initial_states.resize(count);
+    final_states.resize(count);
+
+    // The renumbering keeps the order, so the list of the initial indexes stays sorted
+    std::size_t size = 0;
+    for(auto const index : initials){
+      if(renumber[index] != -1){
+        initials[size++] = renumber[index];
+      }
+    }
+    initials.resize(size);
+
+    transition_count = 0;
+    for(int index = 0; index < count; index++){
+      indexes[values[index]] = index;
+      auto &outgoing = transitions[index];
+      std::size_t size = 0;
+      for(auto const &transition : outgoing){
+        if(renumber[transition.to] != -1){
+          outgoing[size++] = Transition{transition.alpha, renumber[transition.to]};
         }
       }
+      outgoing.resize(size);
+      transition_count += size;
     }
   }
 
   /**
-   * @brief Private recursive function that runs throught the automaton trying to find all states, begining by the finals states
-   * (Used for RemoveNonCoAssessible())
-   * @param state the current state
-   * @param visited the set of states already visited
+   * @brief Private function that finds every state reachable from the initial states
+   * (Used for isLanguageEmpty() and removeNonAccessibleStates())
+   * @return IndexSet the indexes of the accessible states
    */
-  void Automaton::depthFirstSearch_NonCoAccessible(int state, std::set<int> &visited) const{
-    visited.insert(state);
-    for(auto const adjacent_state : map_arcs){
-      if(adjacent_state.second.to == state){
-        if(visited.find(adjacent_state.first) == visited.end()){
-          depthFirstSearch_NonCoAccessible(adjacent_state.first, visited);
+  Automaton::IndexSet Automaton::accessibleIndexes() const{
+    IndexSet visited;
+    visited.resize(values.size());
+    std::vector<int> stack(initials);
+    for(auto const index : initials){
+      visited.insert(index);
+    }
+    while(!stack.empty()){
+      int index = stack.back();
+      stack.pop_back();
+      for(auto const &transition : transitions[index]){
+        if(!visited.test(transition.to)){
+          visited.insert(transition.to);
+          stack.push_back(transition.to);
         }
       }
     }
+    return visited;
   }
 
   /**
-   * @brief Private recursive function that try to find the state(s) where the word end, begining by the initials states
-   * (Used for ReadString())
-   * @param state the current state
-   * @param word the word that we try to find where it will end
-   * @return std::set<int> the state(s) where the word can end 
+   * @brief Private function that finds every state from which a final state can be reached, walking the transitions backward from the final states
+   * (Used for createComplete(), removeNonCoAccessibleStates() and createProduct())
+   * @return IndexSet the indexes of the co-accessible states
    */
-  std::set<int> Automaton::endStateOfWord(int state, const std::string& word) const{
-    std::set<int> rtn_set;
+  Automaton::IndexSet Automaton::coAccessibleIndexes() const{
+    // Predecessors in compressed rows : the predecessors of index are predecessors[offsets[index]] to predecessors[offsets[index + 1] - 1]
+    std::vector<std::size_t> offsets(values.size() + 1, 0);
+    for(auto const &outgoing : transitions){
+      for(auto const &transition : outgoing){
+        offsets[transition.to + 1]++;
+      }
+    }
+    for(std::size_t index = 0; index < values.size(); index++){
+      offsets[index + 1] += offsets[index];
+    }
+    std::vector<int> predecessors(transition_count);
+    std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+    for(std::size_t index = 0; index < values.size(); index++){
+      for(auto const &transition : transitions[index]){
+        predecessors[fill[transition.to]++] = (int)index;
+      }
+    }
 
-    if(word.size() == 0){
-      rtn_set.insert(state);
-    }else{
-      for(auto const adjacent_state : map_arcs){
-        if(adjacent_state.first == state){
-          if(adjacent_state.second.alpha == *word.begin()){
-            std::set<int> recursiv_set = endStateOfWord(adjacent_state.second.to, word.substr(1));
-            std::set<int> merged_set;
-            std::merge(rtn_set.begin(), rtn_set.end(), recursiv_set.begin(), recursiv_set.end(), std::inserter(merged_set, merged_set.end()));
-            rtn_set = merged_set;
-          }
+    IndexSet visited = final_states;
+    std::vector<int> stack;
+    for(std::size_t index = 0; index < values.size(); index++){
+      if(final_states.test(index)){
+        stack.push_back((int)index);
+      }
+    }
+    while(!stack.empty()){
+      int index = stack.back();
+      stack.pop_back();
+      for(std::size_t pred = offsets[index]; pred < offsets[index + 1]; pred++){
+        if(!visited.test(predecessors[pred])){
+          visited.insert(predecessors[pred]);
+          stack.push_back(predecessors[pred]);
         }
       }
     }
-
-    return rtn_set;
+    return visited;
   }
 
   /**
@@ -94,16 +510,58 @@ namespace fa {
    * @param state the number of the state we want to remove the property
    */
   void Automaton::unsetStateFinal(int state){
-    if(hasState(state)){
-      auto search = map_states.find(state);
-      if(search != map_states.end()){
-        search->second.isFinal = false;
+    int index = indexOf(state);
+    if(index != -1){
+      final_states.erase(index);
+    }
+  }
+
+  /**
+   * @brief Private function that computes the states reached from a set of states by reading a letter
+   * (Used for readString() and isEquivalentTo())
+   * @param from the sorted dense indexes of the states we start from
+   * @param alpha the letter that is read
+   * @return std::vector<int> the sorted indexes of the states reached, without duplicates
+   */
+  std::vector<int> Automaton::successorsOf(const std::vector<int>& from, char alpha) const{
+    std::vector<int> successors;
+    for(auto const index : from){
+      for(auto const &transition : transitions[index]){
+        if(transition.alpha == alpha){
+          successors.push_back(transition.to);
+        }
+      }
+    }
+    std::sort(successors.begin(), successors.end());
+    successors.erase(std::unique(successors.begin(), successors.end()), successors.end());
+    return successors;
+  }
+
+  /**
+   * @brief Private function that adds to a sorted set of indexes the indexes reached from them by epsilon-transitions
+   * (Used for readString())
+   * @param indexes the sorted indexes, sorted again when some are added
+   */
+  void Automaton::closeIndexes(std::vector<int>& indexes) const{
+    std::size_t sorted = indexes.size();
+    for(std::size_t position = 0; position < indexes.size(); position++){
+      for(auto const &transition : transitions[indexes[position]]){
+        if(transition.alpha == Epsilon
+          && !std::binary_search(indexes.begin(), indexes.begin() + sorted, transition.to)
+          && std::find(indexes.begin() + sorted, indexes.end(), transition.to) == indexes.end()){
+          indexes.push_back(transition.to);
+        }
       }
     }
+    if(indexes.size() > sorted){
+      std::sort(indexes.begin(), indexes.end());
+    }
   }
 
 
-  Automaton::Automaton() {
+  Automaton::Automaton()
+  : transition_count(0)
+  {
   }
 
   // ------------------- 2.1
@@ -144,12 +602,12 @@ namespace fa {
    */
   bool Automaton::removeSymbol(char symbol) {
     if(hasSymbol(symbol)){
-      for(auto arc = map_arcs.begin(); arc != map_arcs.end(); ){
-        if(arc->second.alpha == symbol){
-         arc = map_arcs.erase(arc);
-        }else{
-          ++arc;
-        }
+      for(auto &outgoing : transitions){
+        std::size_t size = outgoing.size();
+        outgoing.erase(std::remove_if(outgoing.begin(), outgoing.end(), [symbol](const Transition& transition){
+          return transition.alpha == symbol;
+        }), outgoing.end());
+        transition_count -= size - outgoing.size();
       }
       alphabet.erase(symbol);
       return true;
@@ -193,12 +651,11 @@ namespace fa {
    * @return false if the add failed
    */
   bool Automaton::addState(int state) {
-    if(state < 0){
+    if(state < 0 || hasState(state)){
       return false;
     }
-    State state1{state, false, false};
-    std::pair<std::map<int, State>::iterator, bool> ret = map_states.insert({state, state1});
-    return ret.second;
+    appendState(state, false, false);
+    return true;
   }
 
   /**
@@ -209,15 +666,13 @@ namespace fa {
    * @return false if the add failed
    */
   bool Automaton::removeState(int state) {
-    if(hasState(state)){
-      for(auto arc = map_arcs.begin(); arc != map_arcs.end(); ){
-        if(arc->first == state || arc->second.to == state){
-          arc = map_arcs.erase(arc);
-        }else{
-          ++arc;
-        }
-      }
-      map_states.erase(state);
+    int index = indexOf(state);
+    if(index != -1){
+      IndexSet kept;
+      kept.words.assign(initial_states.words.size(), ~std::uint64_t(0));
+      kept.resize(values.size());
+      kept.erase(index);
+      keepIndexes(kept);
       return true;
     }
     return false;
@@ -234,11 +689,7 @@ namespace fa {
     if(state < 0){
       return false;
     }
-    auto search = map_states.find(state);
-    if(search != map_states.end()){
-      return true;
-    }
-    return false;
+    return indexOf(state) != -1;
   }
 
   /**
@@ -247,7 +698,7 @@ namespace fa {
    * @return std::size_t the number of state the automaton has
    */
   std::size_t Automaton::countStates () const{
-    return (size_t) map_states.size();
+    return (size_t) values.size();
   }
 
 
@@ -258,11 +709,9 @@ namespace fa {
    * @param state the state that we want to be initial
    */
   void Automaton::setStateInitial(int state){
-    if(hasState(state)){
-      auto search = map_states.find(state);
-      if(search != map_states.end()){
-        search->second.isInitial = true;
-      }
+    int index = indexOf(state);
+    if(index != -1){
+      setIndexInitial(index);
     }
   }
 
@@ -274,13 +723,8 @@ namespace fa {
    * @return false if the state is initial
    */
   bool Automaton::isStateInitial(int state) const{
-    if(hasState(state)){
-      auto search = map_states.find(state);
-        if(search != map_states.end()){
-          return search->second.isInitial == true;
-        }
-    }
-    return false;
+    int index = indexOf(state);
+    return index != -1 && initial_states.test(index);
   }
   
   /**
@@ -289,11 +733,9 @@ namespace fa {
    * @param state the state that we want to be final
    */
   void Automaton::setStateFinal(int state){
-    if(hasState(state)){
-      auto search = map_states.find(state);
-      if(search != map_states.end()){
-        search->second.isFinal = true;
-      }
+    int index = indexOf(state);
+    if(index != -1){
+      final_states.insert(index);
     }
   }
 
@@ -305,13 +747,8 @@ namespace fa {
    * @return false if the state is final
    */
   bool Automaton::isStateFinal(int state) const{
-    if(hasState(state)){
-      auto search = map_states.find(state);
-        if(search != map_states.end()){
-          return search->second.isFinal == true;
-        }
-    }
-    return false;
+    int index = indexOf(state);
+    return index != -1 && final_states.test(index);
   }
 
    // ------------------- 2.5
@@ -340,8 +777,7 @@ namespace fa {
     if(hasTransition(from, alpha, to)){
       return false;
     }
-    Arc arc1{from, alpha, to};
-    map_arcs.insert({from, arc1});
+    appendTransition(indexOf(from), alpha, indexOf(to));
     return true;
   }
 
@@ -355,10 +791,16 @@ namespace fa {
    * @return false if the remove failed
    */
   bool Automaton::removeTransition(int from, char alpha, int to) {
-    auto search = map_arcs.find(from);
-    for (auto i = search; i != map_arcs.end(); i++){
-      if(i -> second.alpha == alpha && i -> second.to == to){
-        map_arcs.erase(i);
+    int fromIndex = indexOf(from);
+    int toIndex = indexOf(to);
+    if(fromIndex == -1 || toIndex == -1){
+      return false;
+    }
+    auto &outgoing = transitions[fromIndex];
+    for(auto transition = outgoing.begin(); transition != outgoing.end(); ++transition){
+      if(transition->alpha == alpha && transition->to == toIndex){
+        outgoing.erase(transition);
+        transition_count--;
         return true;
       }
     }
@@ -384,49 +826,226 @@ namespace fa {
     if(!hasSymbol(alpha) && alpha != fa::Epsilon){
       return false;
     }
-    if(!hasState(from) || !hasState(to)){
+    int fromIndex = indexOf(from);
+    int toIndex = indexOf(to);
+    if(fromIndex == -1 || toIndex == -1){
       return false;
     }
-    auto search = map_arcs.find(from);
-    for (auto i = search; i != map_arcs.end(); i++){
-      if(i -> second.from == from && i -> second.alpha == alpha && i -> second.to == to){
+    for(auto const &transition : transitions[fromIndex]){
+      if(transition.alpha == alpha && transition.to == toIndex){
         return true;
       }
     }
     return false;
   }
 
+  namespace {
+    /**
+     * @brief Writes into a buffer that is flushed to the stream by large blocks, and stops accepting text after the maximum size
+     * (Used for prettyPrint() and dotPrint())
+     */
+    class BufferedWriter{
+    public:
+      BufferedWriter(std::ostream& os, std::size_t maxBytes)
+      : os(os), maxBytes(maxBytes), written(0)
+      {
+        buffer.reserve(BlockBytes);
+      }
+
+      ~BufferedWriter(){
+        flush();
+      }
+
+      BufferedWriter& operator<<(const char* text){
+        append(text, std::strlen(text));
+        return *this;
+      }
+
+      BufferedWriter& operator<<(const std::string& text){
+        append(text.data(), text.size());
+        return *this;
+      }
+
+      BufferedWriter& operator<<(char letter){
+        append(&letter, 1);
+        return *this;
+      }
+
+      BufferedWriter& operator<<(int number){
+        char digits[16];
+        int size = std::snprintf(digits, sizeof(digits), "%d", number);
+        append(digits, (std::size_t)size);
+        return *this;
+      }
+
+      /**
+       * @brief Tell if the maximum size is reached, so the rest should be replaced by a truncation mark
+       */
+      bool full() const{
+        return maxBytes != 0 && written >= maxBytes;
+      }
+
+      void flush(){
+        os.write(buffer.data(), (std::streamsize)buffer.size());
+        buffer.clear();
+      }
+
+    private:
+      static constexpr std::size_t BlockBytes = 1 << 16;
+
+      std::ostream& os;
+      std::size_t maxBytes;
+      std::size_t written;
+      std::string buffer;
+
+      void append(const char* text, std::size_t size){
+        buffer.append(text, size);
+        written += size;
+        if(buffer.size() >= BlockBytes){
+          flush();
+        }
+      }
+    };
+
+    /**
+     * @brief Sorts the dense indexes by number of state
+     * (Used for prettyPrint() and dotPrint())
+     */
+    std::vector<int> sortedByValue(const std::vector<int>& values){
+      std::vector<int> order(values.size());
+      for(std::size_t index = 0; index < values.size(); index++){
+        order[index] = (int)index;
+      }
+      std::sort(order.begin(), order.end(), [&](int lhs, int rhs){
+        return values[lhs] < values[rhs];
+      });
+      return order;
+    }
+
+    /**
+     * @brief Writes a letter as it should appear in a quoted DOT label
+     * (Used for dotPrint())
+     */
+    std::string dotLabel(char alpha){
+      if(alpha == Epsilon){
+        return "ε";
+      }
+      if(alpha == '"' || alpha == '\\'){
+        return std::string{'\\', alpha};
+      }
+      return std::string(1, alpha);
+    }
+  }
+
   /**
    * @brief Function that draws the current automaton on the stream in parameter
    * 
+   * The transitions of each state are grouped by letter in a single pass, and the text is written by large blocks.
    * @param os where the function should draw the automaton
+   * @param options the maximum size of the output
    */
-  void Automaton::prettyPrint(std::ostream& os) const{
-    os << "Initial states :" << std::endl;
-    for(auto const state : map_states){
-      if(state.second.isInitial){
-        os << "\t " << state.first << std::endl;
+  void Automaton::prettyPrint(std::ostream& os, const PrintOptions& options) const{
+    // The states are drawn by increasing number, whatever their index
+    std::vector<int> order = sortedByValue(values);
+    BufferedWriter out(os, options.maxBytes);
+
+    out << "Initial states :\n";
+    for(auto const index : order){
+      if(initial_states.test(index) && !out.full()){
+        out << "\t " << values[index] << "\n";
       }
     }
-    os << "Final states :" << std::endl;
-    for(auto const state : map_states){
-      if(state.second.isFinal){
-        os << "\t " << state.first << std::endl;
+    out << "Final states :\n";
+    for(auto const index : order){
+      if(final_states.test(index) && !out.full()){
+        out << "\t " << values[index] << "\n";
       }
     }
-    os << "Transitions :" << std::endl;
-    for(auto const state : map_states){
-      os << "\t For state " << state.first << " : " << std::endl;
-      for(auto const letter : alphabet){
-        os << "\t\t For letter " << letter << " : ";
-        for(auto const arc : map_arcs){
-          if(arc.first == state.first && arc.second.alpha == letter){
-            os << arc.second.to << " ";
-          }
+    out << "Transitions :\n";
+    std::vector<char> letters(alphabet.begin(), alphabet.end());
+    std::vector<Transition> sorted;
+    for(auto const index : order){
+      if(out.full()){
+        out << "...\n";
+        return;
+      }
+      // Sorted by letter, the transitions with the same letter keeping the order in which they were added
+      sorted = transitions[index];
+      std::stable_sort(sorted.begin(), sorted.end(), [](const Transition& lhs, const Transition& rhs){
+        return lhs.alpha < rhs.alpha;
+      });
+      out << "\t For state " << values[index] << " : \n";
+      auto transition = sorted.begin();
+      for(auto const letter : letters){
+        out << "\t\t For letter " << letter << " : ";
+        while(transition != sorted.end() && transition->alpha < letter){
+          ++transition;
+        }
+        for(; transition != sorted.end() && transition->alpha == letter; ++transition){
+          out << values[transition->to] << " ";
+        }
+        out << "\n\n";
+      }
+    }
+  }
+
+  /**
+   * @brief Function that draws the current automaton on the stream in parameter, in the DOT language of Graphviz
+   * 
+   * The initial states are pointed by an arrow without origin, and the final states are double circles.
+   * @param os where the function should draw the automaton
+   * @param options if the parallel edges are merged, and the maximum size of the output
+   */
+  void Automaton::dotPrint(std::ostream& os, const PrintOptions& options) const{
+    std::vector<int> order = sortedByValue(values);
+    BufferedWriter out(os, options.maxBytes);
+
+    out << "digraph Automaton {\n";
+    out << "  rankdir=LR;\n";
+    out << "  node [shape=circle];\n";
+    for(auto const index : order){
+      if(out.full()){
+        break;
+      }
+      if(final_states.test(index)){
+        out << "  " << values[index] << " [shape=doublecircle];\n";
+      }else if(transitions[index].empty() && !initial_states.test(index)){
+        out << "  " << values[index] << ";\n";
+      }
+      if(initial_states.test(index)){
+        out << "  start" << values[index] << " [shape=point];\n";
+        out << "  start" << values[index] << " -> " << values[index] << ";\n";
+      }
+    }
+
+    std::vector<Transition> sorted;
+    for(auto const index : order){
+      if(out.full()){
+        out << "  // truncated\n}\n";
+        return;
+      }
+      if(!options.mergeParallelEdges){
+        for(auto const &transition : transitions[index]){
+          out << "  " << values[index] << " -> " << values[transition.to] << " [label=\"" << dotLabel(transition.alpha) << "\"];\n";
+        }
+        continue;
+      }
+      // Sorted by target, then by letter, so the parallel edges are next to each other
+      sorted = transitions[index];
+      std::sort(sorted.begin(), sorted.end(), [this](const Transition& lhs, const Transition& rhs){
+        return values[lhs.to] != values[rhs.to] ? values[lhs.to] < values[rhs.to] : lhs.alpha < rhs.alpha;
+      });
+      for(std::size_t first = 0; first < sorted.size(); ){
+        out << "  " << values[index] << " -> " << values[sorted[first].to] << " [label=\"";
+        std::size_t last = first;
+        for(; last < sorted.size() && sorted[last].to == sorted[first].to; last++){
+          out << (last == first ? "" : ",") << dotLabel(sorted[last].alpha);
         }
-        os << "\n" << std::endl;
+        out << "\"];\n";
+        first = last;
       }
     }
+    out << "}\n";
   }
 
   /**
@@ -435,9 +1054,55 @@ namespace fa {
    * @return std::size_t the number of transitions the automaton has
    */
   std::size_t Automaton::countTransitions () const{
-    return map_arcs.size();
+    return transition_count;
+  }
+
+  namespace {
+    // Approximate bookkeeping of the memory allocator for each allocated block
+    constexpr std::size_t BlockOverhead = 2 * sizeof(void*);
+
+    /**
+     * @brief Give the memory allocated by a vector
+     * (Used for memoryUsage())
+     */
+    template<typename T>
+    std::size_t vectorBytes(const std::vector<T>& vector){
+      return vector.capacity() == 0 ? 0 : vector.capacity() * sizeof(T) + BlockOverhead;
+    }
+  }
+
+  /**
+   * @brief Give the memory used by the current automaton, part by part
+   *
+   * @return MemoryUsage the number of bytes of each part
+   */
+  MemoryUsage Automaton::memoryUsage() const{
+    MemoryUsage usage;
+    usage.states = sizeof(Automaton) + vectorBytes(values) + vectorBytes(transitions) + vectorBytes(initial_states.words) + vectorBytes(final_states.words);
+    for(auto const &arcs : transitions){
+      usage.arcs += vectorBytes(arcs);
+    }
+    usage.alphabet = alphabet.size() * (sizeof(char) + NodeOverhead);
+    // A node of the hash table holds the pair and the pointer to the next node
+    usage.indexes = indexes.bucket_count() * sizeof(void*) + indexes.size() * (sizeof(std::pair<const int, int>) + sizeof(void*) + BlockOverhead);
+    usage.caches = vectorBytes(initials);
+    return usage;
   }
 
+  /**
+   * @brief Reduce the capacity of the containers of the current automaton to their size
+   */
+  void Automaton::shrinkToFit(){
+    values.shrink_to_fit();
+    transitions.shrink_to_fit();
+    for(auto &arcs : transitions){
+      arcs.shrink_to_fit();
+    }
+    initial_states.words.shrink_to_fit();
+    final_states.words.shrink_to_fit();
+    initials.shrink_to_fit();
+    indexes.rehash(0);
+  }
    // ------------------- 3 Propriété d'un automate
   /**
    * @brief tell if the current automaton has epsilon transtions 
@@ -447,9 +1112,11 @@ namespace fa {
    */
   bool Automaton::hasEpsilonTransition () const{
     assert(isValid());
-    for(auto const arc : map_arcs){
-      if(arc.second.alpha == Epsilon){
-        return true;
+    for(auto const &outgoing : transitions){
+      for(auto const &transition : outgoing){
+        if(transition.alpha == Epsilon){
+          return true;
+        }
       }
     }
     return false;
@@ -463,26 +1130,22 @@ namespace fa {
    */
   bool Automaton::isDeterministic () const{
     assert(isValid());
-    size_t initiaux = 0;
-    for(auto const initial : map_states){
-      if(isStateInitial(initial.first)){
-        initiaux++;
-      }
-    }
-    if(initiaux != 1){
+    if(initials.size() != 1){
       return false;
     }
-    for(auto const state1 : map_states){
-      for(auto const letter : alphabet){
-        int count = 0;
-        for(auto const arc : map_arcs){
-          if(arc.first == state1.first && arc.second.alpha == letter){
-            count++;
-          }
+    std::vector<bool> seen(UCHAR_MAX + 1, false);
+    for(auto const &outgoing : transitions){
+      for(auto const &transition : outgoing){
+        if(transition.alpha == Epsilon){
+          continue;
         }
-        if(count > 1){
+        if(seen[(unsigned char)transition.alpha]){
           return false;
         }
+        seen[(unsigned char)transition.alpha] = true;
+      }
+      for(auto const &transition : outgoing){
+        seen[(unsigned char)transition.alpha] = false;
       }
     }
     return true;
@@ -496,24 +1159,45 @@ namespace fa {
    */
   bool Automaton::isComplete () const{
     assert(isValid());
-    for(auto const state1 : map_states){
-      for(auto const letter : alphabet){
-        int count = 0;
-        for(auto const arc : map_arcs){
-          if(arc.first == state1.first && arc.second.alpha == letter){
-            count++;
-          }
-        }
-        if(count < 1){
-          return false;
+    std::vector<bool> seen(UCHAR_MAX + 1, false);
+    for(auto const &outgoing : transitions){
+      std::size_t letters = 0;
+      for(auto const &transition : outgoing){
+        if(transition.alpha != Epsilon && !seen[(unsigned char)transition.alpha]){
+          seen[(unsigned char)transition.alpha] = true;
+          letters++;
         }
       }
+      for(auto const &transition : outgoing){
+        seen[(unsigned char)transition.alpha] = false;
+      }
+      if(letters < alphabet.size()){
+        return false;
+      }
     }
     return true;
   }
 
    // ------------------- 4 Transformation simple d'un automate
-  /**
+  namespace {
+    /**
+     * @brief Give the smallest non-negative number that no state uses, marking the numbers below the count in one pass
+     * (Used for createComplete())
+     * @param values the numbers of the states
+     * @return int a free number
+     */
+    int freeStateOf(const std::vector<int>& values){
+      std::vector<bool> used(values.size() + 1, false);
+      for(auto const value : values){
+        if(value >= 0 && (std::size_t)value < used.size()){
+          used[value] = true;
+        }
+      }
+      return (int)(std::find(used.begin(), used.end(), false) - used.begin());
+    }
+  }
+
+  /**
    * @brief Create a complete Automaton if it is not already
    * 
    * @param other the Automaton that we will use to create his complete version
@@ -526,33 +1210,32 @@ namespace fa {
     }
 
     Automaton automate = automaton;
-    int etat_puit = 0;
+    int etat_puit = freeStateOf(automate.values);
     bool isUsed = false;
-    for(std::size_t etat_puit_it = 0; etat_puit_it <= automaton.countStates(); etat_puit_it++){
-      etat_puit = (int)etat_puit_it;
-      if(automate.addState(etat_puit)){
-        break;
-      }
-    }
+    int sink = automate.appendState(etat_puit, false, false);
 
-    for(auto const state1 : automate.map_states){
+    // The missing transitions of a state that cannot reach a final state loop on it, the others go to the sink
+    IndexSet coAccessible = automate.coAccessibleIndexes();
+    std::vector<bool> seen(UCHAR_MAX + 1, false);
+    for(int index = 0; index < (int)automate.values.size(); index++){
+      auto const &outgoing = automate.transitions[index];
+      std::size_t size = outgoing.size();
+      for(std::size_t transition = 0; transition < size; transition++){
+        seen[(unsigned char)outgoing[transition].alpha] = true;
+      }
       for(auto const letter : automate.alphabet){
-        int count = 0;
-        for(auto const arc : automate.map_arcs){
-          if(arc.first == state1.first && arc.second.alpha == letter){
-            count++;
-          }
-        }
-        std::set<int> visited;
-        if(count < 1){
-          if(automate.depthFirstSearch(state1.first,visited)){
-            automate.addTransition(state1.first, letter, etat_puit);
+        if(!seen[(unsigned char)letter]){
+          if(coAccessible.test(index)){
+            automate.appendTransition(index, letter, sink);
             isUsed = true;
           }else{
-            automate.addTransition(state1.first, letter, state1.first);
+            automate.appendTransition(index, letter, index);
           }
         }
       }
+      for(std::size_t transition = 0; transition < size; transition++){
+        seen[(unsigned char)outgoing[transition].alpha] = false;
+      }
     }
 
     if(!isUsed){
@@ -566,24 +1249,27 @@ namespace fa {
    * @brief Create the complement Automaton of the automaton in parameter
    * 
    * @param other the Automaton that we will use to create his complement
+   * @param limits the limits of the determinization
    * @return the complement Automaton
    */
-  Automaton Automaton::createComplement(const Automaton& automaton){
+  Automaton Automaton::createComplement(const Automaton& automaton, const Limits& limits){
     assert(automaton.isValid());
 
-    Automaton complement = automaton;
+    OperationCache::Ticket ticket;
+    Automaton cachedComplement;
+    if(OperationCache::lookup(OperationCache::Operation::Complement, automaton, ticket, cachedComplement)){
+      Budget(limits).admit(cachedComplement.countStates(), cachedComplement.countTransitions());
+      return cachedComplement;
+    }
 
-    complement = automaton.createDeterministic(automaton);
-    complement = complement.createComplete(complement);
+    Automaton complement = createComplete(createDeterministic(automaton, limits));
 
-    for(auto state : complement.map_states){
-      if(!complement.isStateFinal(state.first)){
-        complement.setStateFinal(state.first);
-      }else{
-        complement.unsetStateFinal(state.first);
-      }
+    for(auto &word : complement.final_states.words){
+      word = ~word;
     }
+    complement.final_states.resize(complement.values.size());
 
+    OperationCache::store(OperationCache::Operation::Complement, ticket, complement);
     return complement;
   }
 
@@ -602,16 +1288,13 @@ namespace fa {
     Automaton automate;
     automate.alphabet = automaton.alphabet;
 
-    for(auto const state : automaton.map_states){
-      automate.addState(state.first);
-      if(automaton.isStateInitial(state.first)){
-        automate.setStateFinal(state.first);
-      }if(automaton.isStateFinal(state.first)){
-        automate.setStateInitial(state.first);
-      }
+    for(std::size_t index = 0; index < automaton.values.size(); index++){
+      automate.appendState(automaton.values[index], automaton.final_states.test(index), automaton.initial_states.test(index));
     }
-    for(auto const arc : automaton.map_arcs){
-      automate.addTransition(arc.second.to, arc.second.alpha, arc.first);
+    for(int index = 0; index < (int)automaton.values.size(); index++){
+      for(auto const &transition : automaton.transitions[index]){
+        automate.appendTransition(transition.to, transition.alpha, index);
+      }
     }
     return automate;
   }
@@ -625,27 +1308,67 @@ namespace fa {
    */
   bool Automaton::isLanguageEmpty() const{
     assert(isValid());
-    std::set <int> set_initial_state;
-    bool has_final_state = false;
-    for(auto const state : map_states){
-      if(isStateInitial(state.first)){
-        set_initial_state.insert(state.first);
-      }
-      if(isStateFinal(state.first)){
-        has_final_state = true;
-      }
-    }
-    if(set_initial_state.empty() || !has_final_state){
+    if(initials.empty() || !final_states.any()){
       return true;
     }
+    return !accessibleIndexes().intersects(final_states);
+  }
 
-    std::set<int> visited;
-    for(auto const inital_state : set_initial_state){
-      if(depthFirstSearch(inital_state, visited)){
-        return false;
+  /**
+   * @brief Find a word of minimal length accepted by the current automaton, with a breadth-first search from the initial states
+   *
+   * The epsilon-transitions are followed without reading a letter : they cost nothing, so the states they reach are
+   * put at the front of the queue (0-1 breadth-first search), and the states are taken by increasing length.
+   * @param word receives the shortest accepted word, if there is one
+   * @return true if the language isn't empty
+   * @return false if the language is empty
+   */
+  bool Automaton::shortestWord(std::string& word) const{
+    assert(isValid());
+
+    // For each reached index : its length, the index we came from (-1 for the initial states) and the letter read to reach it
+    std::vector<std::size_t> lengths(values.size(), std::numeric_limits<std::size_t>::max());
+    std::vector<int> previous(values.size(), -1);
+    std::vector<char> letters(values.size(), Epsilon);
+    std::vector<bool> done(values.size(), false);
+    std::deque<int> queue;
+    for(auto const index : initials){
+      lengths[index] = 0;
+      queue.push_back(index);
+    }
+
+    while(!queue.empty()){
+      int index = queue.front();
+      queue.pop_front();
+      if(done[index]){
+        continue;
+      }
+      done[index] = true;
+      if(final_states.test(index)){
+        word.clear();
+        for(int step = index; previous[step] != -1; step = previous[step]){
+          if(letters[step] != Epsilon){
+            word.push_back(letters[step]);
+          }
+        }
+        std::reverse(word.begin(), word.end());
+        return true;
+      }
+      for(auto const &transition : transitions[index]){
+        std::size_t cost = transition.alpha == Epsilon ? 0 : 1;
+        if(lengths[index] + cost < lengths[transition.to]){
+          lengths[transition.to] = lengths[index] + cost;
+          previous[transition.to] = index;
+          letters[transition.to] = transition.alpha;
+          if(cost == 0){
+            queue.push_front(transition.to);
+          }else{
+            queue.push_back(transition.to);
+          }
+        }
       }
     }
-    return true;
+    return false;
   }
 
   // ------------------- 6 Suppression des états inutiles
@@ -655,45 +1378,16 @@ namespace fa {
    */
   void Automaton::removeNonAccessibleStates(){
     assert(isValid());
-    std::set <int> set_initial_state;
-    for(auto const state : map_states){
-      if(isStateInitial(state.first)){
-        set_initial_state.insert(state.first);
-      }
-    }
-
-    if(set_initial_state.empty()){
-      std::multimap<int, Arc>  empty_map_arcs;
-      std::map<int, State> empty_map_states;
-      map_arcs = empty_map_arcs;
-      map_states = empty_map_states;
+    if(initials.empty()){
+      IndexSet none;
+      none.resize(values.size());
+      keepIndexes(none);
       addState(0);
       setStateInitial(0);
       return;
     }
 
-    std::set<int> visited;
-    for(auto const initial_state : set_initial_state){
-      depthFirstSearch_NonAccessible(initial_state, visited);
-    }
-
-    if(!visited.empty()){
-      for(auto state_automate = map_states.begin(); state_automate != map_states.end(); ){
-        if(visited.find(state_automate->first) == visited.end()){
-          for(auto arc = map_arcs.begin(); arc != map_arcs.end(); ){
-            if(arc->first == state_automate->first || arc->second.to == state_automate->first){
-              arc = map_arcs.erase(arc);
-            }else{
-              ++arc;
-            }
-          }
-          state_automate = map_states.erase(state_automate);
-        }else{
-          ++state_automate;
-        }
-      }
-    }
-
+    keepIndexes(accessibleIndexes());
   }
   /**
    * @brief Remove the non-co-accessibles states of the current automaton
@@ -701,48 +1395,94 @@ namespace fa {
    */
   void Automaton::removeNonCoAccessibleStates(){
     assert(isValid());
-    std::set <int> set_final_state;
-    for(auto const state : map_states){
-      if(isStateFinal(state.first)){
-        set_final_state.insert(state.first);
-      }
-    }
-
-    if(set_final_state.empty()){
-      std::multimap<int, Arc>  empty_map_arcs;
-      std::map<int, State> empty_map_states;
-      map_arcs = empty_map_arcs;
-      map_states = empty_map_states;
+    if(!final_states.any()){
+      IndexSet none;
+      none.resize(values.size());
+      keepIndexes(none);
       addState(0);
       setStateInitial(0);
       return;
     }
 
-    std::set<int> visited;
-    for(auto const final_state : set_final_state){
-      depthFirstSearch_NonCoAccessible(final_state, visited);
-    }
+    keepIndexes(coAccessibleIndexes());
+  }
+
+  
+  // ------------------- 7 Produit d'automate
+  namespace {
+    /**
+     * @brief Open addressing table that gives a dense id to each tuple of states, the tuples being stored contiguously
+     * (Used for createProduct())
+     */
+    class TupleInterner{
+    public:
+      explicit TupleInterner(std::size_t width)
+      : width(width), slots(64, -1)
+      {
+      }
 
-    if(!visited.empty()){
-      for(auto state_automate = map_states.begin(); state_automate != map_states.end(); ){
-        if(visited.find(state_automate->first) == visited.end()){
-          for(auto arc = map_arcs.begin(); arc != map_arcs.end(); ){
-            if(arc->first == state_automate->first || arc->second.to == state_automate->first){
-              arc = map_arcs.erase(arc);
-            }else{
-              ++arc;
+      /**
+       * @brief Find the id of the tuple, or give it the next id if it's a new one
+       *
+       * @param tuple the states of the tuple (width values)
+       * @return the id of the tuple, and true if it has just been added
+       */
+      std::pair<int, bool> intern(const int* tuple){
+        std::size_t mask = slots.size() - 1;
+        for(std::size_t slot = hash(tuple) & mask; ; slot = (slot + 1) & mask){
+          if(slots[slot] == -1){
+            int id = (int)count();
+            storage.insert(storage.end(), tuple, tuple + width);
+            slots[slot] = id;
+            if(2 * count() > slots.size()){
+              grow();
             }
+            return {id, true};
+          }
+          if(std::equal(tuple, tuple + width, get(slots[slot]))){
+            return {slots[slot], false};
           }
-          state_automate = map_states.erase(state_automate);
-        }else{
-          ++state_automate;
         }
       }
-    }
+
+      /**
+       * @brief Give the states of the tuple with this id
+       */
+      const int* get(int id) const{
+        return storage.data() + (std::size_t)id * width;
+      }
+
+      /**
+       * @brief Count the number of interned tuples
+       */
+      std::size_t count() const{
+        return width == 0 ? 0 : storage.size() / width;
+      }
+
+    private:
+      std::size_t width;
+      std::vector<int> storage;
+      std::vector<int> slots;
+
+      std::size_t hash(const int* tuple) const{
+        return hashStates(tuple, width);
+      }
+
+      void grow(){
+        std::vector<int> bigger(slots.size() * 2, -1);
+        std::size_t mask = bigger.size() - 1;
+        for(int id = 0; id < (int)count(); id++){
+          std::size_t slot = hash(get(id)) & mask;
+          while(bigger[slot] != -1){
+            slot = (slot + 1) & mask;
+          }
+          bigger[slot] = id;
+        }
+        slots.swap(bigger);
+      }
+    };
   }
 
-  
-  // ------------------- 7 Produit d'automate
   /**
    * @brief create a synchronized product between two automata : lhs and rhs
    * 
@@ -754,67 +1494,151 @@ namespace fa {
     assert(lhs.isValid());
     assert(rhs.isValid());
 
+    return createProduct(std::vector<const Automaton*>{&lhs, &rhs}, false, Limits());
+  }
+
+  /**
+   * @brief create a synchronized product between all the automata in parameter, through their pointers
+   * 
+   * @param automata the automata to intersect
+   * @param trim true if the tuples that cannot reach a final tuple should be dropped
+   * @param limits the limits of the product
+   * @return Automaton that is the product
+   */
+  Automaton Automaton::createProduct(const std::vector<Automaton>& automata, bool trim, const Limits& limits){
+    std::vector<const Automaton*> pointers;
+    for(auto const &automaton : automata){
+      pointers.push_back(&automaton);
+    }
+    return createProduct(pointers, trim, limits);
+  }
+
+  /**
+   * @brief Build the product of the pointed automata, interning each reachable tuple of states on the fly
+   *
+   * @param automata the automata to intersect, which are not copied
+   * @param trim true if the tuples that cannot reach a final tuple should be dropped
+   * @param limits the limits of the product
+   * @return Automaton that is the product
+   */
+  Automaton Automaton::createProduct(const std::vector<const Automaton*>& automata, bool trim, const Limits& limits){
+    assert(!automata.empty());
+    for(auto const automaton : automata){
+      assert(automaton->isValid());
+    }
+
+    Measure measure;
+    std::size_t width = automata.size();
     Automaton product;
 
-    for(auto const &alph_lhs : lhs.alphabet){
-      for(auto const &alph_rhs : rhs.alphabet){
-        if(alph_lhs == alph_rhs){
-          product.addSymbol(alph_lhs);
+    for(auto const alph : automata.front()->alphabet){
+      bool isShared = true;
+      for(auto const automaton : automata){
+        if(!automaton->hasSymbol(alph)){
+          isShared = false;
+          break;
         }
       }
+      if(isShared){
+        product.addSymbol(alph);
+      }
     }
 
-    std::map<std::pair<int,int>,int> product_states;
-    int nb = 0;
-    for(auto const &state_lhs : lhs.map_states){
-      for(auto const &state_rhs : rhs.map_states){
-        if(lhs.isStateInitial(state_lhs.first) && rhs.isStateInitial(state_rhs.first)){
-          product_states.insert({std::make_pair(state_lhs.first,state_rhs.first),nb});
-          product.addState(nb);
-          product.setStateInitial(nb);
-          if(lhs.isStateFinal(state_lhs.first) && rhs.isStateFinal(state_rhs.first)){
-            product.setStateFinal(nb);
-          }
-          nb++;
-        }
+    std::vector<IndexSet> coAccessible(width);
+    if(trim){
+      for(std::size_t i = 0; i < width; i++){
+        coAccessible[i] = automata[i]->coAccessibleIndexes();
       }
     }
 
-    for(auto const state : product_states){
-      for(auto const alph : product.alphabet){
+    // A tuple is dead if one of its states cannot reach a final state anymore
+    auto isAlive = [&](const int* tuple){
+      if(!trim){
+        return true;
+      }
+      for(std::size_t i = 0; i < width; i++){
+        if(!coAccessible[i].test(tuple[i])){
+          return false;
+        }
+      }
+      return true;
+    };
 
-        std::set<int> lhs_to;
-        for(auto const state_lhs : lhs.map_states){
-          if(lhs.hasTransition(state.first.first, alph, state_lhs.first)){
-            lhs_to.insert(state_lhs.first);
+    Budget budget(limits);
+    TupleInterner tuples(width);
+    auto addTuple = [&](const int* tuple){
+      std::pair<int, bool> interned = tuples.intern(tuple);
+      if(interned.second){
+        budget.addState(StateBytes + width * sizeof(int));
+        bool isFinal = true;
+        for(std::size_t i = 0; i < width; i++){
+          if(!automata[i]->final_states.test(tuple[i])){
+            isFinal = false;
           }
         }
+        product.appendState(interned.first, false, isFinal);
+      }
+      return interned.first;
+    };
 
-        std::set<int> rhs_to;
-        for(auto const state_rhs : rhs.map_states){
-          if(rhs.hasTransition(state.first.second, alph, state_rhs.first)){
-            rhs_to.insert(state_rhs.first);
-          }
+    // Enumerates every tuple taking one state in each set, like an odometer
+    std::vector<std::vector<int>> choices(width);
+    std::vector<std::size_t> digits(width);
+    std::vector<int> tuple(width);
+    auto forEachTuple = [&](const std::function<void(const int*)>& callback){
+      for(auto const &choice : choices){
+        if(choice.empty()){
+          return;
+        }
+      }
+      std::fill(digits.begin(), digits.end(), 0);
+      for(;;){
+        for(std::size_t i = 0; i < width; i++){
+          tuple[i] = choices[i][digits[i]];
+        }
+        if(isAlive(tuple.data())){
+          callback(tuple.data());
+        }
+        std::size_t i = 0;
+        while(i < width && ++digits[i] == choices[i].size()){
+          digits[i] = 0;
+          i++;
+        }
+        if(i == width){
+          return;
         }
+      }
+    };
 
-        for(auto const lhs_state_to : lhs_to){
-          for(auto const rhs_state_to : rhs_to){
-            auto key_product_state = product_states.find(std::make_pair(lhs_state_to,rhs_state_to));
-            if(key_product_state != product_states.end()){
-              product.addTransition(state.second, alph, key_product_state->second);
-            }else{
-              product_states.insert({std::make_pair(lhs_state_to,rhs_state_to),nb});
-              product.addState(nb);
-              product.addTransition(state.second, alph, nb);
-              if(lhs.isStateFinal(lhs_state_to) && rhs.isStateFinal(rhs_state_to)){
-                product.setStateFinal(nb);
-              }
-              nb++;
+    for(std::size_t i = 0; i < width; i++){
+      choices[i] = automata[i]->initials;
+    }
+    forEachTuple([&](const int* initial){
+      product.setIndexInitial(addTuple(initial));
+    });
+
+    // The interner gives increasing ids, so the tuples are explored in breadth-first order
+    for(int current = 0; current < (int)tuples.count(); current++){
+      std::vector<int> from(tuples.get(current), tuples.get(current) + width);
+      for(auto const alph : product.alphabet){
+        for(std::size_t i = 0; i < width; i++){
+          choices[i].clear();
+          for(auto const &transition : automata[i]->transitions[from[i]]){
+            if(transition.alpha == alph){
+              choices[i].push_back(transition.to);
             }
           }
         }
+        forEachTuple([&](const int* to){
+          int target = addTuple(to);
+          product.appendTransition(current, alph, target);
+          budget.addTransition();
+        });
       }
     }
+    if(measure.get() != nullptr){
+      measure.get()->productPairs += tuples.count();
+    }
 
     if(!product.isValid()){
       if(product.countSymbols() == 0){
@@ -833,15 +1657,24 @@ namespace fa {
    * @brief Check if the intersection between two automata is empty or not
    * 
    * @param other the other automaton whith we will check
+   * @param witness if not null, receives a shortest word of the intersection when it isn't empty
    * @return true if the intersection between automata is empty
    * @return false if the intersection between automata isn't empty
    */
-  bool Automaton::hasEmptyIntersectionWith(const Automaton& other) const{
+  bool Automaton::hasEmptyIntersectionWith(const Automaton& other, std::string* witness) const{
     assert(isValid());
     assert(other.isValid());
-    
+
+    Measure measure;
     Automaton product = createProduct(*this, other);
-    return product.isLanguageEmpty();
+    std::string word;
+    if(!product.shortestWord(word)){
+      return true;
+    }
+    if(witness != nullptr){
+      *witness = word;
+    }
+    return false;
   }
 
   // ------------------- 8 Lecture d'un mot
@@ -854,34 +1687,102 @@ namespace fa {
    */
   std::set<int> Automaton::readString(const std::string& word) const{
     assert(isValid());
-    std::set<int> deriv;
+    // The set of indexes where the prefix read so far can end, one letter at a time, closed by the epsilon-transitions
+    std::vector<int> current = initials;
+    closeIndexes(current);
+    for(std::size_t letter = 0; letter < word.size() && !current.empty(); letter++){
+      current = successorsOf(current, word[letter]);
+      closeIndexes(current);
+    }
 
-    std::set <int> set_initial_state;
-    for(auto const state : map_states){
-      if(isStateInitial(state.first)){
-        set_initial_state.insert(state.first);
-      }
+    std::set<int> deriv;
+    for(auto const index : current){
+      deriv.insert(values[index]);
     }
+    return deriv;
+  }
 
-    for(auto initial_state : set_initial_state){
-      std::set<int> r = endStateOfWord(initial_state, word);
-      std::set<int> recursiv_set = endStateOfWord(initial_state, word);
-      std::set<int> merged_set;
-      std::merge(deriv.begin(), deriv.end(), recursiv_set.begin(), recursiv_set.end(), std::inserter(merged_set, merged_set.end()));
-      deriv = merged_set;
+  /**
+   * @brief Private function that reads the word with the set of current states kept in a few machine words, without sorting nor allocating
+   * (Used for match())
+   * @param word the word that we want to know if the automaton can read it
+   * @return true if the automaton can read the word in parameter
+   * @return false if the automaton cannot read the word in parameter
+   */
+  template<std::size_t Words>
+  bool Automaton::matchWords(const std::string& word) const{
+    std::uint64_t current[Words] = {};
+    std::uint64_t next[Words];
+    for(auto const index : initials){
+      current[index >> 6] |= std::uint64_t(1) << (index & 63);
     }
 
-    return deriv;
+    // Read the letter from every state of current, the states reached by an epsilon-transition joining current
+    // and being read in turn, until no state is added : without epsilon-transitions, one pass is enough
+    auto read = [&](bool hasLetter, char alpha){
+      std::uint64_t reached = 0;
+      std::uint64_t done[Words] = {};
+      for(bool isGrown = true; isGrown; ){
+        isGrown = false;
+        for(std::size_t block = 0; block < Words; block++){
+          std::uint64_t bits = current[block] & ~done[block];
+          done[block] |= bits;
+          for(; bits != 0; bits &= bits - 1){
+            int index = (int)(block * 64) + __builtin_ctzll(bits);
+            for(auto const &transition : transitions[index]){
+              std::uint64_t bit = std::uint64_t(1) << (transition.to & 63);
+              if(hasLetter && transition.alpha == alpha){
+                next[transition.to >> 6] |= bit;
+                reached = 1;
+              }else if(transition.alpha == Epsilon && (current[transition.to >> 6] & bit) == 0){
+                current[transition.to >> 6] |= bit;
+                isGrown = true;
+              }
+            }
+          }
+        }
+      }
+      return reached != 0;
+    };
+
+    for(auto const alpha : word){
+      std::fill(next, next + Words, 0);
+      if(!read(true, alpha)){
+        return false;
+      }
+      std::copy(next, next + Words, current);
+    }
+    read(false, Epsilon);
+    for(std::size_t block = 0; block < final_states.words.size(); block++){
+      if((current[block] & final_states.words[block]) != 0){
+        return true;
+      }
+    }
+    return false;
   }
 
   /**
    * @brief Says if the current automaton can read a word or not
    * 
+   * The automata of at most BitParallelMatcher::MaxStates states are simulated with their set of current states in machine words.
+   * The epsilon-transitions are followed, like in shortestWord().
    * @param word the word that we want to know if the automaton can read it
    * @return true if the automaton can read the word in parameter
    * @return false if the automaton cannot read the word in parameter
    */
   bool Automaton::match(const std::string& word) const{
+    if(values.size() <= 64){
+      assert(isValid());
+      return matchWords<1>(word);
+    }
+    if(values.size() <= 128){
+      assert(isValid());
+      return matchWords<2>(word);
+    }
+    if(values.size() <= BitParallelMatcher::MaxStates){
+      assert(isValid());
+      return matchWords<4>(word);
+    }
     std::set<int> deriv = readString(word);
     for(auto state : deriv){
       if(isStateFinal(state)){
@@ -893,79 +1794,96 @@ namespace fa {
 
   // ------------------- 9 Determinisation d'un automate
 
+  namespace {
+    /**
+     * @brief Hash of a sorted set of states stored in a vector
+     * (Used for createDeterministic(), createDeterministicParallel() and isEquivalentTo())
+     */
+    struct SubsetHash{
+      std::size_t operator()(const std::vector<int>& subset) const{
+        return hashStates(subset.data(), subset.size());
+      }
+    };
+
+    /**
+     * @brief Transition between two states numbered from 0, the letter being its position in the sorted alphabet
+     * (Used for createDeterministicParallel() and createMinimalBrzozowski())
+     */
+    struct Edge{
+      int from;
+      std::size_t letter;
+      int to;
+    };
+  }
+
   /**
    * @brief Create a deterministic Automaton if it is not already
    * 
    * @param other the Automaton that we will use to create his deterministic version
+   * @param limits the limits of the determinization
    * @return a deterministic Automaton
    */
-  Automaton Automaton::createDeterministic(const Automaton& other){
+  Automaton Automaton::createDeterministic(const Automaton& other, const Limits& limits){
     assert(other.isValid());
+
+    Measure measure;
+    OperationCache::Ticket ticket;
+    Automaton cachedAutomaton;
+    if(OperationCache::lookup(OperationCache::Operation::Deterministic, other, ticket, cachedAutomaton)){
+      Budget(limits).admit(cachedAutomaton.countStates(), cachedAutomaton.countTransitions());
+      return cachedAutomaton;
+    }
     if(other.isDeterministic()){
       return other;
     }
 
+    Budget budget(limits);
+    // Each new state costs its place in the automaton and its set of states in deterministic_states
+    auto subsetBytes = [](const std::vector<int>& subset){
+      return StateBytes + sizeof(std::vector<int>) + NodeOverhead + subset.size() * sizeof(int);
+    };
+
     Automaton deterministicAutomaton;
     deterministicAutomaton.alphabet = other.alphabet;
 
-    std::map<int,std::set<int>> deterministic_states;
-    std::set<int> initial_deterministic_state;
-
-    int nb = 0;
-
-    // Initial State of the deterministic Automaton
-    for(auto const state : other.map_states){
-      if(other.isStateInitial(state.first)){
-        initial_deterministic_state.insert(state.first);
-      }
-    }
-    deterministic_states.insert({nb,initial_deterministic_state});
-    deterministicAutomaton.addState(nb);
-    deterministicAutomaton.setStateInitial(nb);
-    for(auto const state : initial_deterministic_state){
-      if(other.isStateFinal(state)){
-        deterministicAutomaton.setStateFinal(nb);
+    // The sorted sets of indexes of the other automaton, the position of a set being its state in the deterministic automaton
+    std::vector<std::vector<int>> deterministic_states;
+    std::unordered_map<std::vector<int>, int, SubsetHash> numbers;
+    auto addSubset = [&](std::vector<int>&& subset){
+      budget.addState(subsetBytes(subset));
+      int nb = (int)deterministic_states.size();
+      bool isFinal = false;
+      for(auto const index : subset){
+        if(other.final_states.test(index)){
+          isFinal = true;
+        }
       }
-    }
+      deterministicAutomaton.appendState(nb, false, isFinal);
+      numbers.insert({subset, nb});
+      deterministic_states.push_back(std::move(subset));
+      return nb;
+    };
 
-    nb++;
+    // Initial State of the deterministic Automaton
+    std::vector<int> initial_deterministic_state = other.initials;
+    addSubset(std::move(initial_deterministic_state));
+    deterministicAutomaton.setIndexInitial(0);
 
-    // Rest of the states of the deterministic Automaton
-    for(auto const state_det : deterministic_states){
+    // Rest of the states of the deterministic Automaton, in breadth-first order
+    for(std::size_t current = 0; current < deterministic_states.size(); current++){
       for(auto const alph : deterministicAutomaton.alphabet){
-        // On créer le tableau a insérer dans la map deterministic_states pour pouvoir parcourir ses noeuds et voir les transitions
-        std::set<int> set_alph;
-        // On Ajoute dans ce tableau les transitions que notre automate ancien automate allait, pour avoir les nouvels états
-        for(auto const state : state_det.second){
-          for(auto const arc : other.map_arcs){
-            if(arc.first == state && arc.second.alpha == alph){
-              set_alph.insert(arc.second.to);
-            }
-          }
-        }
+        std::vector<int> set_alph = other.successorsOf(deterministic_states[current], alph);
         if(set_alph.size() > 0){
-          // On créer cette variable booléenne pour faire l'une des deux vérifications
-          bool isPassed = false;
-          for(auto const state_det_v2 : deterministic_states){
-            if(state_det_v2.second == set_alph){
-              deterministicAutomaton.addTransition(state_det.first, alph, state_det_v2.first);
-              isPassed = true;
-            }
-          }
-          if(!isPassed){
-            deterministicAutomaton.addState(nb);
-            for(auto const state : set_alph){
-              if(other.isStateFinal(state)){
-                deterministicAutomaton.setStateFinal(nb);
-              }
-            }
-            deterministicAutomaton.addTransition(state_det.first, alph, nb);
-            deterministic_states.insert({nb,set_alph});
-            nb++;
-          }
+          budget.addTransition();
+          auto search = numbers.find(set_alph);
+          int target = search != numbers.end() ? search->second : addSubset(std::move(set_alph));
+          deterministicAutomaton.appendTransition((int)current, alph, target);
         }
       }
     }
+    if(measure.get() != nullptr){
+      measure.get()->subsetsCreated += deterministic_states.size();
+    }
 
     if(!deterministicAutomaton.isValid()){
       Automaton emptyAutomaton;
@@ -975,149 +1893,4395 @@ namespace fa {
       deterministicAutomaton.setStateInitial(0);
     }
 
+    OperationCache::store(OperationCache::Operation::Deterministic, ticket, deterministicAutomaton);
     return deterministicAutomaton;
   }
 
   /**
-   * @brief Check if the current automaton language is included in the other automaton language
-   * 
-   * @param other the other automaton whith we will check
-   * @return true if the current automaton language is included in the other automaton language
-   * @return false if the current automaton language is included in the other automaton language
+   * @brief Create a deterministic Automaton if it is not already, exploring the sets of states with several threads
+   *
+   * Each thread takes the sets of states to explore from its own deque, and steals from the other deques when its own is empty.
+   * The deques are protected by a mutex each, so the stealing is mutex-based, and a thread that finds no task sleeps
+   * on a condition variable until a task is pushed or the exploration is over.
+   * The sets of states are given an id in a hash table split into shards, each one with its own lock.
+   * The states are renumbered at the end in breadth-first order, so the result doesn't depend on the scheduling of the threads.
+   * @param other the Automaton that we will use to create his deterministic version
+   * @param threads the number of threads, or 0 to use one thread per core
+   * @param limits the limits of the determinization
+   * @return a deterministic Automaton
    */
-  bool Automaton::isIncludedIn(const Automaton& other) const{
-    // if(A isIncludedIn B <==> A hasEmptyIntersectionWith b.createComplement)
+  Automaton Automaton::createDeterministicParallel(const Automaton& other, unsigned threads, const Limits& limits){
     assert(other.isValid());
-    Automaton copyOther = other;
-    for(auto const alph : alphabet){
-      if(!copyOther.hasSymbol(alph)){
-        copyOther.addSymbol(alph);
-      }
+    Measure measure;
+    if(other.isDeterministic()){
+      return other;
+    }
+    if(threads == 0){
+      threads = std::max(1u, std::thread::hardware_concurrency());
     }
-    Automaton otherComplement = createComplement(copyOther);
-    return hasEmptyIntersectionWith(otherComplement);
-  }
-
-  // ------------------- 10 Minimisation d'un automate
-  /**
-   * @brief Create a automaton deterministic and complete and then, reduce the number of state of this one if it's possible
-   * 
-   * @param other the automaton that will serve to create a minimal Automaton
-   * @return A minimal Automaton thanks to Moore algorithm 
-   */
-  Automaton Automaton::createMinimalMoore(const Automaton& other){
-    assert(other.isValid());
 
-    Automaton minimalAutomaton;
-    minimalAutomaton = createDeterministic(other);
-    minimalAutomaton = createComplete(minimalAutomaton);
+    // The states of the other automaton are numbered from 0, and their successors are grouped by letter
+    std::vector<char> letters(other.alphabet.begin(), other.alphabet.end());
+    std::size_t width = letters.size();
+    std::vector<bool> finals;
+    std::vector<int> initials = other.initials;
+    for(std::size_t index = 0; index < other.values.size(); index++){
+      finals.push_back(other.final_states.test(index));
+    }
+    std::vector<std::vector<int>> successors(other.values.size() * width);
+    for(std::size_t index = 0; index < other.values.size(); index++){
+      for(auto const &transition : other.transitions[index]){
+        std::size_t letter = std::lower_bound(letters.begin(), letters.end(), transition.alpha) - letters.begin();
+        if(letter < width && letters[letter] == transition.alpha){
+          successors[index * width + letter].push_back(transition.to);
+        }
+      }
+    }
 
-    struct Moore{ 
-      int congruenceFrom;
-      std::vector<int> transitions;
-      int congruenceTo; 
+    struct Task{
+      int id;
+      std::vector<int> subset;
+    };
+    struct Worker{
+      std::mutex mutex;
+      std::deque<Task> tasks;
+      std::vector<std::pair<int, bool>> states;
+      std::vector<Edge> edges;
+    };
+    struct Shard{
+      std::mutex mutex;
+      std::unordered_map<std::vector<int>, int, SubsetHash> ids;
     };
 
-    std::map<int, Moore> classes;
+    const std::size_t shardCount = 64;
+    std::vector<Shard> shards(shardCount);
+    std::vector<Worker> workers(threads);
+    std::atomic<int> nextId(0);
+    std::atomic<std::size_t> pending(0); // Tasks pushed and not explored yet
+    std::atomic<std::size_t> queued(0); // Tasks in the deques
+    std::atomic<std::size_t> parked(0); // Threads waiting for a task
+    std::mutex parkMutex;
+    std::condition_variable wakeUp;
+    std::atomic<bool> stop(false);
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    Budget budget(limits);
 
-    // Congruence 0 de l'algorithme de Moore, on met les etats non finaux a la classe 1 et ceux finaux a la classe 2;
-    for(auto const state : minimalAutomaton.map_states){
-      struct Moore st;
-      if(minimalAutomaton.isStateFinal(state.first)){
-        st.congruenceFrom = 2;
-      }else{
-        st.congruenceFrom = 1;
+    // Give an id to the set of states, and push it in the deque of the worker if it's a new one
+    auto intern = [&](std::vector<int>& subset, std::size_t worker){
+      Shard &shard = shards[(SubsetHash()(subset) >> 16) % shardCount];
+      int id;
+      {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto search = shard.ids.find(subset);
+        if(search != shard.ids.end()){
+          return search->second;
+        }
+        id = nextId++;
+        shard.ids.insert({subset, id});
       }
-      classes.insert({state.first, st});
-    }
-
-    bool areSames;  //Variable premettant d'arreter le do while CongruenceFrom = CongruenceTo ?
-    do{
-
-      for(auto &itera : classes){
-        itera.second.transitions.clear();
+      budget.addState(StateBytes + sizeof(std::vector<int>) + NodeOverhead + subset.size() * sizeof(int));
+      pending++;
+      {
+        std::lock_guard<std::mutex> lock(workers[worker].mutex);
+        workers[worker].tasks.push_back(Task{id, subset});
       }
+      queued++;
+      // A parked thread checks queued while holding parkMutex, so taking it before notifying doesn't lose the wake up
+      if(parked > 0){
+        std::lock_guard<std::mutex> lock(parkMutex);
+        wakeUp.notify_one();
+      }
+      return id;
+    };
 
-      areSames = true;
+    // Wake up all the parked threads, when the exploration is over or has failed
+    auto wakeAll = [&](){
+      std::lock_guard<std::mutex> lock(parkMutex);
+      wakeUp.notify_all();
+    };
 
-      for(auto const alpha : minimalAutomaton.alphabet){
-        for(auto const transition : minimalAutomaton.map_arcs){
-          if(transition.second.alpha == alpha){ 
-            classes[transition.first].transitions.push_back(classes[transition.second.to].congruenceFrom);
+    // Take the newest task of its own deque, or else the oldest task of another deque
+    auto takeTask = [&](std::size_t self, Task& task){
+      for(std::size_t i = 0; i < threads; i++){
+        Worker &victim = workers[(self + i) % threads];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if(!victim.tasks.empty()){
+          if(i == 0){
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+          }else{
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
           }
+          queued--;
+          return true;
         }
       }
+      return false;
+    };
 
-      int numero_classe = 1;
-      for(std::map<int, Moore>::iterator iterator = classes.begin(); iterator != classes.end(); iterator++){
-        bool isPassed = false;
-        for(std::map<int, Moore>::iterator checking = classes.begin(); checking != iterator; checking++){
-          if(checking->second.congruenceFrom == iterator->second.congruenceFrom && checking->second.transitions == iterator->second.transitions){
-            iterator->second.congruenceTo = checking->second.congruenceTo;
-            isPassed = true;
-            break;
+    auto run = [&](std::size_t self){
+      try{
+        Task task;
+        std::vector<int> next;
+        while(!stop){
+          if(!takeTask(self, task)){
+            if(pending == 0){
+              return;
+            }
+            std::unique_lock<std::mutex> lock(parkMutex);
+            parked++;
+            wakeUp.wait(lock, [&]{
+              return queued > 0 || pending == 0 || stop;
+            });
+            parked--;
+            continue;
+          }
+          bool isFinal = false;
+          for(auto const state : task.subset){
+            if(finals[state]){
+              isFinal = true;
+              break;
+            }
+          }
+          workers[self].states.push_back({task.id, isFinal});
+          for(std::size_t letter = 0; letter < width; letter++){
+            next.clear();
+            for(auto const state : task.subset){
+              auto const &to = successors[state * width + letter];
+              next.insert(next.end(), to.begin(), to.end());
+            }
+            if(next.empty()){
+              continue;
+            }
+            std::sort(next.begin(), next.end());
+            next.erase(std::unique(next.begin(), next.end()), next.end());
+            workers[self].edges.push_back(Edge{task.id, letter, intern(next, self)});
+            budget.addTransition();
+          }
+          if(--pending == 0){
+            wakeAll();
           }
         }
-        if(!isPassed){
-          iterator->second.congruenceTo = numero_classe;
-          numero_classe++;
+      }catch(...){
+        {
+          std::lock_guard<std::mutex> lock(errorMutex);
+          if(!error){
+            error = std::current_exception();
+          }
         }
+        stop = true;
+        wakeAll();
       }
+    };
 
-      // On vérifie si la congruence précédente et la suivante (ou actuelle) sont les mêmes, si oui, l'automate est minimal, on arrête donc d'itérer
-      for(auto &it : classes){
-        if(it.second.congruenceFrom != it.second.congruenceTo){
-          it.second.congruenceFrom = it.second.congruenceTo;
-          areSames = false;
-        }
-      }
-    }while(!areSames);
+    intern(initials, 0);
+    std::vector<std::thread> pool;
+    for(std::size_t self = 1; self < threads; self++){
+      pool.emplace_back(run, self);
+    }
+    run(0);
+    for(auto &thread : pool){
+      thread.join();
+    }
+    if(error){
+      std::rethrow_exception(error);
+    }
 
-    // Contruction de l'automate minimal Moore
-    Automaton minimalAutomatonMoore;
-    // > Alphabet
-    minimalAutomatonMoore.alphabet = minimalAutomaton.alphabet;
-    // > Les etats
-    for(auto const st : classes){
-      minimalAutomatonMoore.addState(st.second.congruenceFrom);
-      if(minimalAutomaton.isStateInitial(st.first)){
-        minimalAutomatonMoore.setStateInitial(st.second.congruenceFrom);
+    // Renumbering in breadth-first order, with the letters in alphabetical order, like createDeterministic()
+    std::size_t count = (std::size_t)nextId.load();
+    if(measure.get() != nullptr){
+      measure.get()->subsetsCreated += count;
+    }
+    std::vector<bool> isFinal(count, false);
+    std::vector<int> table(count * width, -1);
+    for(auto const &worker : workers){
+      for(auto const &state : worker.states){
+        isFinal[state.first] = state.second;
       }
-      if(minimalAutomaton.isStateFinal(st.first)){
-        minimalAutomatonMoore.setStateFinal(st.second.congruenceFrom);
+      for(auto const &edge : worker.edges){
+        table[edge.from * width + edge.letter] = edge.to;
       }
     }
-    // > Les transitions
-    int i = 0;
-    for(auto const alpha : minimalAutomatonMoore.alphabet){
-      for(auto const tr : classes){
-        minimalAutomatonMoore.addTransition(tr.second.congruenceFrom, alpha, tr.second.transitions[i]);
+    std::vector<int> renumbered(count, -1);
+    std::vector<int> order;
+    renumbered[0] = 0;
+    order.push_back(0);
+    for(std::size_t current = 0; current < order.size(); current++){
+      for(std::size_t letter = 0; letter < width; letter++){
+        int to = table[order[current] * width + letter];
+        if(to != -1 && renumbered[to] == -1){
+          renumbered[to] = (int)order.size();
+          order.push_back(to);
+        }
+      }
+    }
+
+    Automaton deterministicAutomaton;
+    deterministicAutomaton.alphabet = other.alphabet;
+    for(std::size_t state = 0; state < order.size(); state++){
+      deterministicAutomaton.appendState((int)state, state == 0, isFinal[order[state]]);
+    }
+    for(std::size_t state = 0; state < order.size(); state++){
+      for(std::size_t letter = 0; letter < width; letter++){
+        int to = table[order[state] * width + letter];
+        if(to != -1){
+          deterministicAutomaton.appendTransition((int)state, letters[letter], renumbered[to]);
+        }
+      }
+    }
+    return deterministicAutomaton;
+  }
+
+  /**
+   * @brief Check if the current automaton language is included in the other automaton language
+   * 
+   * @param other the other automaton whith we will check
+   * @param counterexample if not null, receives a shortest word accepted by the current automaton only, when the language isn't included
+   * @return true if the current automaton language is included in the other automaton language
+   * @return false if the current automaton language is included in the other automaton language
+   */
+  bool Automaton::isIncludedIn(const Automaton& other, std::string* counterexample) const{
+    // if(A isIncludedIn B <==> A hasEmptyIntersectionWith b.createComplement)
+    assert(other.isValid());
+    Measure measure;
+    // The other automaton is only copied when its alphabet misses some letters
+    if(std::includes(other.alphabet.begin(), other.alphabet.end(), alphabet.begin(), alphabet.end())){
+      return hasEmptyIntersectionWith(createComplement(other), counterexample);
+    }
+    Automaton copyOther = other;
+    for(auto const alph : alphabet){
+      if(!copyOther.hasSymbol(alph)){
+        copyOther.addSymbol(alph);
+      }
+    }
+    Automaton otherComplement = createComplement(copyOther);
+    return hasEmptyIntersectionWith(otherComplement, counterexample);
+  }
+
+  /**
+   * @brief Check if the current automaton language is the same as the other automaton language, with the Hopcroft-Karp algorithm
+   *
+   * Both automata are determinized on the fly, and the pairs of sets of states that must be equivalent are merged in a union-find.
+   * The pairs are explored in breadth-first order, so the counterexample is a short word.
+   * @param other the other automaton whith we will check
+   * @param counterexample if not null, receives a word accepted by only one of the automata when the languages differ
+   * @return true if the languages are the same
+   * @return false if the languages are different
+   */
+  bool Automaton::isEquivalentTo(const Automaton& other, std::string* counterexample) const{
+    assert(isValid());
+    assert(other.isValid());
+
+    Measure measure;
+    const Automaton* automata[2] = {this, &other};
+
+    std::set<char> letters = alphabet;
+    letters.insert(other.alphabet.begin(), other.alphabet.end());
+
+    // Each set of states met on one side gets an id, shared by both sides for the union-find
+    std::unordered_map<std::vector<int>, int, SubsetHash> ids[2];
+    std::vector<std::vector<int>> subsets;
+    std::vector<bool> accepting;
+    std::vector<int> parent;
+    auto intern = [&](int side, const std::vector<int>& subset){
+      auto search = ids[side].find(subset);
+      if(search != ids[side].end()){
+        return search->second;
+      }
+      int id = (int)subsets.size();
+      ids[side].insert({subset, id});
+      subsets.push_back(subset);
+      bool isAccepting = false;
+      for(auto const index : subset){
+        if(automata[side]->final_states.test(index)){
+          isAccepting = true;
+          break;
+        }
+      }
+      accepting.push_back(isAccepting);
+      parent.push_back(id);
+      return id;
+    };
+    auto find = [&](int id){
+      while(parent[id] != id){
+        parent[id] = parent[parent[id]];
+        id = parent[id];
+      }
+      return id;
+    };
+
+    struct Pair{
+      int lhs;
+      int rhs;
+      int previous;
+      char alpha;
+    };
+    std::vector<Pair> pairs;
+    auto record = [&](){
+      if(measure.get() != nullptr){
+        measure.get()->subsetsCreated += subsets.size();
+        measure.get()->productPairs += pairs.size();
+      }
+    };
+
+    for(int side = 0; side < 2; side++){
+      intern(side, automata[side]->initials);
+    }
+    pairs.push_back(Pair{0, 1, -1, Epsilon});
+
+    for(std::size_t current = 0; current < pairs.size(); current++){
+      int lhs = pairs[current].lhs;
+      int rhs = pairs[current].rhs;
+      if(accepting[lhs] != accepting[rhs]){
+        if(counterexample != nullptr){
+          counterexample->clear();
+          for(int pair = (int)current; pairs[pair].previous != -1; pair = pairs[pair].previous){
+            counterexample->push_back(pairs[pair].alpha);
+          }
+          std::reverse(counterexample->begin(), counterexample->end());
+        }
+        record();
+        return false;
+      }
+      if(current == 0){
+        parent[find(rhs)] = find(lhs);
+      }
+      for(auto const alph : letters){
+        int lhs_to = intern(0, successorsOf(subsets[lhs], alph));
+        int rhs_to = intern(1, automata[1]->successorsOf(subsets[rhs], alph));
+        int lhs_root = find(lhs_to);
+        int rhs_root = find(rhs_to);
+        if(lhs_root != rhs_root){
+          parent[rhs_root] = lhs_root;
+          pairs.push_back(Pair{lhs_to, rhs_to, (int)current, alph});
+        }
+      }
+    }
+    record();
+    return true;
+  }
+
+  // ------------------- 10 Minimisation d'un automate
+  /**
+   * @brief Create a automaton deterministic and complete and then, reduce the number of state of this one if it's possible
+   * 
+   * @param other the automaton that will serve to create a minimal Automaton
+   * @param limits the limits of the determinization and of the refinement rounds
+   * @return A minimal Automaton thanks to Moore algorithm 
+   */
+  Automaton Automaton::createMinimalMoore(const Automaton& other, const Limits& limits){
+    assert(other.isValid());
+
+    Measure measure;
+    OperationCache::Ticket ticket;
+    Automaton cachedAutomaton;
+    if(OperationCache::lookup(OperationCache::Operation::MinimalMoore, other, ticket, cachedAutomaton)){
+      Budget(limits).admit(cachedAutomaton.countStates(), cachedAutomaton.countTransitions());
+      return cachedAutomaton;
+    }
+
+    Budget budget(limits);
+    Automaton minimalAutomaton;
+    minimalAutomaton = createDeterministic(other, limits);
+    minimalAutomaton = createComplete(minimalAutomaton);
+
+    // The states are taken by increasing number, which gives the numbers of the classes
+    std::size_t count = minimalAutomaton.values.size();
+    std::vector<int> order(count);
+    for(std::size_t index = 0; index < count; index++){
+      order[index] = (int)index;
+    }
+    std::sort(order.begin(), order.end(), [&](int lhs, int rhs){
+      return minimalAutomaton.values[lhs] < minimalAutomaton.values[rhs];
+    });
+
+    std::vector<char> letters(minimalAutomaton.alphabet.begin(), minimalAutomaton.alphabet.end());
+    std::size_t width = letters.size();
+    std::vector<int> next(count * width, -1);
+    for(std::size_t index = 0; index < count; index++){
+      for(auto const &transition : minimalAutomaton.transitions[index]){
+        std::size_t letter = std::lower_bound(letters.begin(), letters.end(), transition.alpha) - letters.begin();
+        if(letter < width && letters[letter] == transition.alpha){
+          next[index * width + letter] = transition.to;
+        }
+      }
+    }
+
+    // Congruence 0 de l'algorithme de Moore, on met les etats non finaux a la classe 1 et ceux finaux a la classe 2;
+    std::vector<int> congruenceFrom(count);
+    std::vector<int> congruenceTo(count);
+    for(std::size_t index = 0; index < count; index++){
+      congruenceFrom[index] = minimalAutomaton.final_states.test(index) ? 2 : 1;
+    }
+
+    bool areSames;  //Variable premettant d'arreter le do while CongruenceFrom = CongruenceTo ?
+    do{
+      budget.poll();
+      if(measure.get() != nullptr){
+        measure.get()->refinementRounds++;
+      }
+
+      areSames = true;
+
+      // Two states stay in the same class if they were in the same class and their successors too : the first state with a signature numbers its class
+      std::map<std::vector<int>, int> numbers;
+      std::vector<int> signature(width + 1);
+      for(auto const index : order){
+        signature[0] = congruenceFrom[index];
+        for(std::size_t letter = 0; letter < width; letter++){
+          signature[letter + 1] = congruenceFrom[next[index * width + letter]];
+        }
+        auto inserted = numbers.insert({signature, (int)numbers.size() + 1});
+        congruenceTo[index] = inserted.first->second;
+      }
+
+      // On vérifie si la congruence précédente et la suivante (ou actuelle) sont les mêmes, si oui, l'automate est minimal, on arrête donc d'itérer
+      for(std::size_t index = 0; index < count; index++){
+        if(congruenceFrom[index] != congruenceTo[index]){
+          congruenceFrom[index] = congruenceTo[index];
+          areSames = false;
+        }
+      }
+    }while(!areSames);
+
+    // Contruction de l'automate minimal Moore
+    Automaton minimalAutomatonMoore;
+    // > Alphabet
+    minimalAutomatonMoore.alphabet = minimalAutomaton.alphabet;
+    // > Les etats, et les transitions de la premiere etat de chaque classe
+    std::vector<int> representatives;
+    for(auto const index : order){
+      int classe = congruenceFrom[index];
+      int classIndex = minimalAutomatonMoore.indexOf(classe);
+      if(classIndex == -1){
+        classIndex = minimalAutomatonMoore.appendState(classe, false, false);
+        representatives.push_back(index);
+      }
+      if(minimalAutomaton.initial_states.test(index)){
+        minimalAutomatonMoore.setIndexInitial(classIndex);
+      }
+      if(minimalAutomaton.final_states.test(index)){
+        minimalAutomatonMoore.final_states.insert(classIndex);
+      }
+    }
+    for(std::size_t classIndex = 0; classIndex < representatives.size(); classIndex++){
+      for(std::size_t letter = 0; letter < width; letter++){
+        int to = congruenceFrom[next[representatives[classIndex] * width + letter]];
+        minimalAutomatonMoore.appendTransition((int)classIndex, letters[letter], minimalAutomatonMoore.indexOf(to));
+      }
+    }
+
+    OperationCache::store(OperationCache::Operation::MinimalMoore, ticket, minimalAutomatonMoore);
+    return minimalAutomatonMoore;
+  }
+
+  /**
+   * @brief Create a automaton deterministic and complete and then, reduce the number of state of this one if it's possible, sharing each round between several threads
+   *
+   * At each round, the signature of a state is its class and the classes of its successors, computed by chunks in parallel.
+   * The states are then sorted by signature in parallel, so that the states with the same signature are next to each other and get the same new class :
+   * the first state of each run is marked in parallel, and the runs are numbered by a prefix sum over the chunks.
+   * The rounds stop when the number of classes doesn't change anymore. The threads are started once for all the rounds.
+   * @param other the automaton that will serve to create a minimal Automaton
+   * @param threads the number of threads, or 0 to use one thread per core
+   * @param limits the limits of the determinization and of the refinement rounds
+   * @return A minimal Automaton thanks to Moore algorithm
+   */
+  Automaton Automaton::createMinimalMooreParallel(const Automaton& other, unsigned threads, const Limits& limits){
+    assert(other.isValid());
+    Measure measure;
+    if(threads == 0){
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    Budget budget(limits);
+    Automaton complete = createComplete(createDeterministicParallel(other, threads, limits));
+
+    std::vector<char> letters(complete.alphabet.begin(), complete.alphabet.end());
+    std::size_t width = letters.size();
+    std::size_t count = complete.values.size();
+    std::vector<int> next(count * width, -1);
+    for(std::size_t state = 0; state < count; state++){
+      for(auto const &transition : complete.transitions[state]){
+        std::size_t letter = std::lower_bound(letters.begin(), letters.end(), transition.alpha) - letters.begin();
+        if(letter < width && letters[letter] == transition.alpha){
+          next[state * width + letter] = transition.to;
+        }
+      }
+    }
+    // The classes are numbered in the order of the numbers of the states
+    std::vector<int> byValue(count);
+    for(std::size_t state = 0; state < count; state++){
+      byValue[state] = (int)state;
+    }
+    std::sort(byValue.begin(), byValue.end(), [&](int lhs, int rhs){
+      return complete.values[lhs] < complete.values[rhs];
+    });
+
+    // Congruence 0 : the states are split between the non final ones and the final ones
+    std::vector<int> classes(count);
+    for(std::size_t state = 0; state < count; state++){
+      classes[state] = complete.final_states.test(state) ? 1 : 0;
+    }
+
+    WorkerPool pool(threads);
+    std::size_t stride = width + 1;
+    std::vector<int> signatures(count * stride);
+    std::vector<int> sorted(count);
+    std::vector<char> isFirst(count); // isFirst[position] : the state sorted at this position has not the signature of the previous one
+    std::vector<std::size_t> runsBefore(threads + 1); // Number of runs of signatures that begin in the chunks before each chunk
+    std::vector<int> runs(count); // runs[state] : number of the run of the state in the sorted order
+    std::vector<int> order(count); // order[run] : new class of the run, 0 until it is given
+    std::size_t classCount = 0;
+    auto signature = [&](int state){
+      return signatures.begin() + state * stride;
+    };
+    auto isBefore = [&](int lhs, int rhs){
+      return std::lexicographical_compare(signature(lhs), signature(lhs) + stride, signature(rhs), signature(rhs) + stride);
+    };
+    auto isSame = [&](int lhs, int rhs){
+      return std::equal(signature(lhs), signature(lhs) + stride, signature(rhs));
+    };
+
+    for(;;){
+      budget.poll();
+      if(measure.get() != nullptr){
+        measure.get()->refinementRounds++;
+      }
+
+      pool.parallelFor(count, [&](std::size_t begin, std::size_t end){
+        for(std::size_t state = begin; state < end; state++){
+          signatures[state * stride] = classes[state];
+          for(std::size_t letter = 0; letter < width; letter++){
+            signatures[state * stride + letter + 1] = classes[next[state * width + letter]];
+          }
+        }
+      });
+
+      // Each thread sorts its chunk, then the sorted chunks are merged two by two
+      for(std::size_t state = 0; state < count; state++){
+        sorted[state] = (int)state;
+      }
+      std::size_t chunk = pool.chunkSize(count);
+      pool.parallelFor(count, [&](std::size_t begin, std::size_t end){
+        std::sort(sorted.begin() + begin, sorted.begin() + end, isBefore);
+      });
+      for(std::size_t merged = chunk; merged < count; merged *= 2){
+        std::size_t pairs = (count + 2 * merged - 1) / (2 * merged);
+        pool.parallelFor(pairs, [&](std::size_t begin, std::size_t end){
+          for(std::size_t pair = begin; pair < end; pair++){
+            std::size_t first = pair * 2 * merged;
+            std::size_t middle = std::min(first + merged, count);
+            std::size_t last = std::min(first + 2 * merged, count);
+            std::inplace_merge(sorted.begin() + first, sorted.begin() + middle, sorted.begin() + last, isBefore);
+          }
+        });
+      }
+
+      // The states with the same signature are consecutive : each chunk counts the runs that begin in it,
+      // then the runs are numbered from the number of runs in the chunks before
+      std::fill(runsBefore.begin(), runsBefore.end(), 0);
+      pool.parallelFor(count, [&](std::size_t begin, std::size_t end){
+        std::size_t firsts = 0;
+        for(std::size_t position = begin; position < end; position++){
+          isFirst[position] = position == 0 || !isSame(sorted[position - 1], sorted[position]);
+          firsts += isFirst[position];
+        }
+        runsBefore[begin / chunk + 1] = firsts;
+      });
+      for(std::size_t thread = 1; thread <= threads; thread++){
+        runsBefore[thread] += runsBefore[thread - 1];
       }
-      i++;
+      pool.parallelFor(count, [&](std::size_t begin, std::size_t end){
+        std::size_t run = runsBefore[begin / chunk];
+        for(std::size_t position = begin; position < end; position++){
+          run += isFirst[position];
+          runs[sorted[position]] = (int)run - 1;
+        }
+      });
+      std::size_t newCount = runsBefore[threads];
+
+      // The new classes are numbered from 1 in the order of the numbers of the states, like createMinimalMoore()
+      std::fill(order.begin(), order.begin() + newCount, 0);
+      int nextClass = 1;
+      for(auto const state : byValue){
+        int &id = order[runs[state]];
+        if(id == 0){
+          id = nextClass++;
+        }
+        classes[state] = id;
+      }
+
+      if(newCount == classCount){
+        break;
+      }
+      classCount = newCount;
     }
 
+    Automaton minimalAutomatonMoore;
+    minimalAutomatonMoore.alphabet = complete.alphabet;
+    std::vector<int> representatives;
+    for(auto const state : byValue){
+      int id = classes[state];
+      int classIndex = minimalAutomatonMoore.indexOf(id);
+      if(classIndex == -1){
+        classIndex = minimalAutomatonMoore.appendState(id, false, false);
+        representatives.push_back(state);
+      }
+      if(complete.initial_states.test(state)){
+        minimalAutomatonMoore.setIndexInitial(classIndex);
+      }
+      if(complete.final_states.test(state)){
+        minimalAutomatonMoore.final_states.insert(classIndex);
+      }
+    }
+    for(std::size_t classIndex = 0; classIndex < representatives.size(); classIndex++){
+      for(std::size_t letter = 0; letter < width; letter++){
+        int to = classes[next[representatives[classIndex] * width + letter]];
+        minimalAutomatonMoore.appendTransition((int)classIndex, letters[letter], minimalAutomatonMoore.indexOf(to));
+      }
+    }
     return minimalAutomatonMoore;
   }
 
+  namespace {
     /**
+     * @brief Subset construction of the mirror of an automaton, done directly on its transitions without building the mirror
+     * (Used for createMinimalBrzozowski())
+     * The buffers are kept from one call to the next, so the two passes of Brzozowski share them.
+     */
+    class MirrorDeterminizer{
+    public:
+      /**
+       * @brief Determinize the mirror of the automaton given by its transitions
+       *
+       * @param states the number of states of the automaton
+       * @param width the number of letters
+       * @param edges the transitions of the automaton
+       * @param finals the final states of the automaton, which are the initial states of the mirror
+       * @param isInitial the initial states of the automaton, which are the final states of the mirror
+       * @param budget the budget of the determinization
+       * @param next receives the transitions of the deterministic automaton, next[state * width + letter] being -1 if there is none
+       * @param isFinal receives the final states of the deterministic automaton, whose initial state is 0
+       */
+      void run(std::size_t states, std::size_t width, const std::vector<Edge>& edges, const std::vector<int>& finals, const std::vector<bool>& isInitial, Budget& budget, std::vector<int>& next, std::vector<bool>& isFinal){
+        // Predecessors of each state, grouped by letter
+        offsets.assign(states * width + 1, 0);
+        for(auto const &edge : edges){
+          offsets[edge.to * width + edge.letter + 1]++;
+        }
+        for(std::size_t i = 1; i < offsets.size(); i++){
+          offsets[i] += offsets[i - 1];
+        }
+        predecessors.resize(edges.size());
+        position.assign(offsets.begin(), offsets.end() - 1);
+        for(auto const &edge : edges){
+          predecessors[position[edge.to * width + edge.letter]++] = edge.from;
+        }
+
+        ids.clear();
+        subsets.clear();
+        next.clear();
+        isFinal.clear();
+        intern(finals, budget);
+        for(std::size_t current = 0; current < subsets.size(); current++){
+          for(std::size_t letter = 0; letter < width; letter++){
+            scratch.clear();
+            for(auto const state : subsets[current]){
+              scratch.insert(scratch.end(), predecessors.begin() + offsets[state * width + letter], predecessors.begin() + offsets[state * width + letter + 1]);
+            }
+            if(scratch.empty()){
+              next.push_back(-1);
+              continue;
+            }
+            std::sort(scratch.begin(), scratch.end());
+            scratch.erase(std::unique(scratch.begin(), scratch.end()), scratch.end());
+            int to = intern(scratch, budget);
+            next.push_back(to);
+            budget.addTransition();
+          }
+          isFinal.push_back(std::any_of(subsets[current].begin(), subsets[current].end(), [&](int state){
+            return isInitial[state];
+          }));
+        }
+      }
+
+    private:
+      std::vector<int> offsets;
+      std::vector<int> position;
+      std::vector<int> predecessors;
+      std::unordered_map<std::vector<int>, int, SubsetHash> ids;
+      std::vector<std::vector<int>> subsets;
+      std::vector<int> scratch;
+
+      int intern(const std::vector<int>& subset, Budget& budget){
+        auto inserted = ids.insert({subset, (int)subsets.size()});
+        if(inserted.second){
+          budget.addState(StateBytes + subset.size() * sizeof(int));
+          subsets.push_back(subset);
+        }
+        return inserted.first->second;
+      }
+    };
+  }
+
+  /**
    * @brief Create a automaton deterministic and complete and then, reduce the number of state of this one if it's possible
-   * 
+   *
+   * The mirror is determinized twice directly from the transitions, without building the intermediate automata.
    * @param other the automaton that will serve to create a minimal Automaton
+   * @param limits the limits of each determinization
    * @return A minimal Automaton thanks to Brzozowski algorithm 
    */
-  Automaton Automaton::createMinimalBrzozowski(const Automaton& other){
+  Automaton Automaton::createMinimalBrzozowski(const Automaton& other, const Limits& limits){
     assert(other.isValid());
+    Measure measure;
 
     // Brzozowski -> CreateDeterministe(CreateMirror(CreateDeterministic(CreateMirror(other))));
 
-    Automaton minimalAutomaton = fa::Automaton::createMirror(other);
-    minimalAutomaton = fa::Automaton::createDeterministic(minimalAutomaton);
+    std::vector<char> letters(other.alphabet.begin(), other.alphabet.end());
+    std::size_t width = letters.size();
+    std::vector<bool> isInitial;
+    std::vector<int> finals;
+    for(std::size_t index = 0; index < other.values.size(); index++){
+      isInitial.push_back(other.initial_states.test(index));
+      if(other.final_states.test(index)){
+        finals.push_back((int)index);
+      }
+    }
+    std::vector<Edge> edges;
+    for(std::size_t index = 0; index < other.values.size(); index++){
+      for(auto const &transition : other.transitions[index]){
+        std::size_t letter = std::lower_bound(letters.begin(), letters.end(), transition.alpha) - letters.begin();
+        if(letter < width && letters[letter] == transition.alpha){
+          edges.push_back(Edge{(int)index, letter, transition.to});
+        }
+      }
+    }
+
+    MirrorDeterminizer determinizer;
+    std::vector<int> next;
+    std::vector<bool> isFinal;
+
+    // First pass : determinization of the mirror of other
+    Budget firstBudget(limits);
+    determinizer.run(isInitial.size(), width, edges, finals, isInitial, firstBudget, next, isFinal);
+
+    // Second pass : determinization of the mirror of the first result
+    std::size_t states = isFinal.size();
+    edges.clear();
+    finals.clear();
+    for(std::size_t state = 0; state < states; state++){
+      for(std::size_t letter = 0; letter < width; letter++){
+        if(next[state * width + letter] != -1){
+          edges.push_back(Edge{(int)state, letter, next[state * width + letter]});
+        }
+      }
+      if(isFinal[state]){
+        finals.push_back((int)state);
+      }
+    }
+    isInitial.assign(states, false);
+    isInitial[0] = true;
+    Budget secondBudget(limits);
+    determinizer.run(states, width, edges, finals, isInitial, secondBudget, next, isFinal);
+    if(measure.get() != nullptr){
+      measure.get()->subsetsCreated += states + isFinal.size();
+    }
+
+    Automaton minimalAutomaton;
+    minimalAutomaton.alphabet = other.alphabet;
+    for(std::size_t state = 0; state < isFinal.size(); state++){
+      minimalAutomaton.appendState((int)state, state == 0, isFinal[state]);
+    }
+    for(std::size_t state = 0; state < isFinal.size(); state++){
+      for(std::size_t letter = 0; letter < width; letter++){
+        int to = next[state * width + letter];
+        if(to != -1){
+          minimalAutomaton.appendTransition((int)state, letters[letter], to);
+        }
+      }
+    }
+
+    return fa::Automaton::createComplete(minimalAutomaton);
+  }
+
+  // ------------------- 11 Comptage et enumeration des mots
+  namespace {
+    /**
+     * @brief Add two counts, keeping the maximum value instead of overflowing
+     */
+    std::uint64_t saturatedAdd(std::uint64_t lhs, std::uint64_t rhs){
+      return lhs > std::numeric_limits<std::uint64_t>::max() - rhs ? std::numeric_limits<std::uint64_t>::max() : lhs + rhs;
+    }
+  }
+
+  /**
+   * @brief Private function that numbers the states of the deterministic version of the current automaton and stores its transitions in a table
+   * (Used for countWords() and enumerate())
+   * @return Table the transition table
+   */
+  Automaton::Table Automaton::createTable() const{
+    Automaton deterministic = createDeterministic(*this);
+
+    Table table;
+    table.letters.assign(deterministic.alphabet.begin(), deterministic.alphabet.end());
+    table.initial = -1;
+
+    for(std::size_t index = 0; index < deterministic.values.size(); index++){
+      table.finals.push_back(deterministic.final_states.test(index));
+    }
+    if(!deterministic.initials.empty()){
+      table.initial = deterministic.initials.front();
+    }
+
+    std::size_t width = table.letters.size();
+    table.next.assign(deterministic.values.size() * width, -1);
+    for(std::size_t index = 0; index < deterministic.values.size(); index++){
+      for(auto const &transition : deterministic.transitions[index]){
+        std::size_t letter = std::lower_bound(table.letters.begin(), table.letters.end(), transition.alpha) - table.letters.begin();
+        if(letter < width && table.letters[letter] == transition.alpha){
+          table.next[index * width + letter] = transition.to;
+        }
+      }
+    }
+    return table;
+  }
+
+  /**
+   * @brief Private function that counts, for each length and each state, the number of words of this length that lead from the state to a final state
+   * (Used for enumerate())
+   * @param table the transition table
+   * @param maxLength the greatest length counted
+   * @return the saturated counts, indexed by length and then by state
+   */
+  std::vector<std::vector<std::uint64_t>> Automaton::countSuffixes(const Table& table, std::size_t maxLength){
+    std::size_t width = table.letters.size();
+    std::vector<std::vector<std::uint64_t>> counts(maxLength + 1, std::vector<std::uint64_t>(table.finals.size(), 0));
+    for(std::size_t state = 0; state < table.finals.size(); state++){
+      counts[0][state] = table.finals[state] ? 1 : 0;
+    }
+    for(std::size_t length = 1; length <= maxLength; length++){
+      for(std::size_t state = 0; state < table.finals.size(); state++){
+        std::uint64_t count = 0;
+        for(std::size_t letter = 0; letter < width; letter++){
+          int to = table.next[state * width + letter];
+          if(to != -1){
+            count = saturatedAdd(count, counts[length - 1][to]);
+          }
+        }
+        counts[length][state] = count;
+      }
+    }
+    return counts;
+  }
+
+  /**
+   * @brief Count the words of a given length accepted by the current automaton, by dynamic programming over its deterministic version
+   * 
+   * @param length the length of the counted words
+   * @return the number of accepted words, or the maximum std::uint64_t value if it does not fit
+   */
+  std::uint64_t Automaton::countWords(std::size_t length) const{
+    assert(isValid());
+    Table table = createTable();
+    if(table.initial == -1){
+      return 0;
+    }
+
+    std::size_t width = table.letters.size();
+    std::vector<std::uint64_t> counts(table.finals.size());
+    std::vector<std::uint64_t> previous(table.finals.size());
+    for(std::size_t state = 0; state < table.finals.size(); state++){
+      counts[state] = table.finals[state] ? 1 : 0;
+    }
+    for(std::size_t step = 0; step < length; step++){
+      counts.swap(previous);
+      for(std::size_t state = 0; state < table.finals.size(); state++){
+        std::uint64_t count = 0;
+        for(std::size_t letter = 0; letter < width; letter++){
+          int to = table.next[state * width + letter];
+          if(to != -1){
+            count = saturatedAdd(count, previous[to]);
+          }
+        }
+        counts[state] = count;
+      }
+    }
+    return counts[table.initial];
+  }
+
+  /**
+   * @brief Give the accepted words of the current automaton to a visitor, by increasing length and then in alphabetical order
+   *
+   * The branches that cannot lead to an accepted word of the current length are cut, so each step of the search leads to a word.
+   * @param maxLength the greatest length of the enumerated words
+   * @param visitor the function called on each word, that returns false to stop the enumeration
+   */
+  void Automaton::enumerate(std::size_t maxLength, const std::function<bool(const std::string&)>& visitor) const{
+    assert(isValid());
+    Table table = createTable();
+    if(table.initial == -1){
+      return;
+    }
 
-    minimalAutomaton = fa::Automaton::createMirror(minimalAutomaton);
-    minimalAutomaton = fa::Automaton::createDeterministic(minimalAutomaton);
+    std::size_t width = table.letters.size();
+    std::vector<std::vector<std::uint64_t>> counts = countSuffixes(table, maxLength);
 
-    minimalAutomaton = fa::Automaton::createComplete(minimalAutomaton);
+    std::string word;
+    std::vector<int> path;
+    std::vector<std::size_t> nextLetter;
+    for(std::size_t length = 0; length <= maxLength; length++){
+      if(counts[length][table.initial] == 0){
+        continue;
+      }
+      word.clear();
+      path.assign(1, table.initial);
+      nextLetter.assign(1, 0);
+      while(!path.empty()){
+        if(word.size() == length){
+          if(!visitor(word)){
+            return;
+          }
+          path.pop_back();
+          nextLetter.pop_back();
+          if(!word.empty()){
+            word.pop_back();
+          }
+          continue;
+        }
+        std::size_t remaining = length - word.size() - 1;
+        std::size_t &letter = nextLetter.back();
+        int to = -1;
+        while(letter < width){
+          to = table.next[path.back() * width + letter];
+          letter++;
+          if(to != -1 && counts[remaining][to] != 0){
+            break;
+          }
+          to = -1;
+        }
+        if(to == -1){
+          path.pop_back();
+          nextLetter.pop_back();
+          if(!word.empty()){
+            word.pop_back();
+          }
+          continue;
+        }
+        word.push_back(table.letters[letter - 1]);
+        path.push_back(to);
+        nextLetter.push_back(0);
+      }
+    }
+  }
 
-    return minimalAutomaton;
-   }
-}
\ No newline at end of file
+  // ------------------- 12 Tirage aleatoire de mots
+  /**
+   * @brief Build the transition table of the automaton and count the accepted words from each state, for each length up to maxLength,
+   * and for each first letter
+   * 
+   * @param automaton the automaton whose words will be drawn
+   * @param maxLength the greatest length of the drawn words
+   * @param seed the seed of the random generator
+   */
+  WordSampler::WordSampler(const Automaton& automaton, std::size_t maxLength, std::uint64_t seed)
+  : table(automaton.createTable()), counts(Automaton::countSuffixes(table, maxLength)), generator(seed)
+  {
+    std::size_t width = table.letters.size();
+    prefixes.assign(maxLength, std::vector<std::uint64_t>(table.next.size(), 0));
+    for(std::size_t length = 0; length < maxLength; length++){
+      for(std::size_t state = 0; state < table.finals.size(); state++){
+        std::uint64_t count = 0;
+        for(std::size_t letter = 0; letter < width; letter++){
+          int to = table.next[state * width + letter];
+          if(to != -1){
+            count = saturatedAdd(count, counts[length][to]);
+          }
+          prefixes[length][state * width + letter] = count;
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Restart the random generator
+   * 
+   * @param seed the new seed of the random generator
+   */
+  void WordSampler::seed(std::uint64_t seed){
+    generator.seed(seed);
+  }
+
+  /**
+   * @brief Give the number of accepted words of a given length
+   * 
+   * @param length the length of the counted words
+   * @return the saturated number of accepted words, 0 if the length is greater than the maxLength given to the constructor
+   */
+  std::uint64_t WordSampler::countWords(std::size_t length) const{
+    if(length >= counts.size() || table.initial == -1){
+      return 0;
+    }
+    return counts[length][table.initial];
+  }
+
+  /**
+   * @brief Draw a word of a given length, choosing each letter with a probability proportional to the number of words it leads to,
+   * by a binary search in the cumulative counts of the letters
+   * 
+   * @param length the length of the drawn word
+   * @param word receives the drawn word
+   * @return true if a word has been drawn
+   * @return false if no word of this length is accepted, or if the length is greater than the maxLength given to the constructor
+   */
+  bool WordSampler::sample(std::size_t length, std::string& word){
+    if(countWords(length) == 0){
+      return false;
+    }
+
+    std::size_t width = table.letters.size();
+    word.resize(length);
+    int state = table.initial;
+    for(std::size_t position = 0; position < length; position++){
+      std::size_t remaining = length - position - 1;
+      auto row = prefixes[remaining].begin() + state * width;
+      std::uniform_int_distribution<std::uint64_t> distribution(0, row[width - 1] - 1);
+      std::uint64_t draw = distribution(generator);
+      // The chosen letter is the first one whose cumulative count is greater than the draw, so the letters leading to no word are skipped
+      std::size_t chosen = std::upper_bound(row, row + width, draw) - row;
+      word[position] = table.letters[chosen];
+      state = table.next[state * width + chosen];
+    }
+    return true;
+  }
+
+  // ------------------- 13 Limites des transformations
+  /**
+   * @brief Collect the statistics of the operations of the thread until the scope is destroyed
+   *
+   * @param statistics the counters to increase
+   */
+  StatisticsScope::StatisticsScope(Statistics& statistics)
+  : previous(activeStatistics)
+  {
+    activeStatistics = &statistics;
+  }
+
+  /**
+   * @brief Give back the statistics collected before the scope
+   */
+  StatisticsScope::~StatisticsScope(){
+    activeStatistics = previous;
+  }
+
+  namespace {
+    /**
+     * @brief Give the message of a LimitExceeded error
+     */
+    const char* describe(LimitExceeded::Reason reason){
+      switch(reason){
+        case LimitExceeded::Reason::States:
+          return "the maximum number of states is exceeded";
+        case LimitExceeded::Reason::Bytes:
+          return "the maximum memory is exceeded";
+        case LimitExceeded::Reason::Deadline:
+          return "the deadline is exceeded";
+        case LimitExceeded::Reason::Cancelled:
+          return "the transformation has been cancelled";
+      }
+      return "a limit is exceeded";
+    }
+  }
+
+  /**
+   * @brief Build the error thrown when a transformation goes beyond its limits
+   * 
+   * @param reason the exceeded limit
+   * @param states the number of states created before the transformation was stopped
+   */
+  LimitExceeded::LimitExceeded(Reason reason, std::size_t states)
+  : std::runtime_error(describe(reason)), limitReason(reason), createdStates(states)
+  {
+  }
+
+  /**
+   * @brief Tell which limit has been exceeded
+   */
+  LimitExceeded::Reason LimitExceeded::reason() const{
+    return limitReason;
+  }
+
+  /**
+   * @brief Give the number of states created before the transformation was stopped
+   */
+  std::size_t LimitExceeded::states() const{
+    return createdStates;
+  }
+
+  /**
+   * @brief Give an upper bound of the number of states of the deterministic automaton
+   *
+   * After reading a letter, a set of states is a union of the sets of successors of the states by this letter,
+   * so there are at most 2^k such sets if k different sets of successors exist for this letter.
+   * If the automaton is already deterministic, its number of states is returned.
+   * @param other the automaton that would be determinized
+   * @return the upper bound, saturated to the maximum std::size_t value
+   */
+  std::size_t Automaton::estimateDeterministicStates(const Automaton& other){
+    assert(other.isValid());
+    if(other.isDeterministic()){
+      return other.countStates();
+    }
+
+    const std::size_t saturated = std::numeric_limits<std::size_t>::max();
+    auto powerOfTwo = [&](std::size_t exponent){
+      return exponent >= std::numeric_limits<std::size_t>::digits ? saturated : (std::size_t(1) << exponent);
+    };
+
+    std::size_t estimate = 1;
+    for(auto const alph : other.alphabet){
+      std::set<std::vector<int>> successors;
+      for(std::size_t index = 0; index < other.values.size(); index++){
+        std::vector<int> to = other.successorsOf(std::vector<int>{(int)index}, alph);
+        if(!to.empty()){
+          successors.insert(to);
+        }
+      }
+      std::size_t sets = powerOfTwo(successors.size()) - 1;
+      estimate = estimate > saturated - sets ? saturated : estimate + sets;
+    }
+    return std::min(estimate, powerOfTwo(other.countStates()));
+  }
+
+  // ------------------- 14 Forme canonique
+  namespace {
+    /**
+     * @brief Mix the bits of a 64 bits value (finalizer of SplitMix64)
+     */
+    std::uint64_t mix(std::uint64_t value){
+      value ^= value >> 30;
+      value *= 0xBF58476D1CE4E5B9ULL;
+      value ^= value >> 27;
+      value *= 0x94D049BB133111EBULL;
+      value ^= value >> 31;
+      return value;
+    }
+
+    /**
+     * @brief Hash bytes on 128 bits, with two 64 bits lanes that are mixed together at the end
+     */
+    Hash128 hashBytes(const std::string& bytes){
+      std::uint64_t low = 0x9E3779B97F4A7C15ULL ^ bytes.size();
+      std::uint64_t high = 0xC2B2AE3D27D4EB4FULL;
+      for(auto const byte : bytes){
+        low = (low ^ (unsigned char)byte) * 0x100000001B3ULL;
+        high = (high + (unsigned char)byte) * 0xFF51AFD7ED558CCDULL;
+        high ^= high >> 32;
+      }
+      low = mix(low ^ mix(high));
+      high = mix(high ^ low);
+      return Hash128{low, high};
+    }
+
+    /**
+     * @brief Append an integer to bytes, in little endian
+     */
+    void appendBytes(std::string& bytes, std::uint32_t value){
+      for(int shift = 0; shift < 32; shift += 8){
+        bytes.push_back((char)((value >> shift) & 0xFF));
+      }
+    }
+  }
+
+  bool operator==(const Hash128& lhs, const Hash128& rhs){
+    return lhs.low == rhs.low && lhs.high == rhs.high;
+  }
+
+  bool operator!=(const Hash128& lhs, const Hash128& rhs){
+    return !(lhs == rhs);
+  }
+
+  bool operator<(const Hash128& lhs, const Hash128& rhs){
+    return lhs.high < rhs.high || (lhs.high == rhs.high && lhs.low < rhs.low);
+  }
+
+  /**
+   * @brief Replace the current automaton by its canonical form
+   * 
+   */
+  void Automaton::canonicalize(){
+    assert(isValid());
+    *this = createCanonical(*this);
+  }
+
+  /**
+   * @brief Create the minimal complete deterministic version of an automaton, with the states renumbered in breadth-first order
+   * 
+   * @param other the automaton that will serve to create the canonical form
+   * @return the canonical Automaton
+   */
+  Automaton Automaton::createCanonical(const Automaton& other){
+    assert(other.isValid());
+    Automaton minimal = createMinimalBrzozowski(other);
+
+    std::vector<int> renumbered(minimal.values.size(), -1);
+    std::vector<int> order;
+    for(auto const index : minimal.initials){
+      renumbered[index] = 0;
+      order.push_back(index);
+    }
+    for(std::size_t current = 0; current < order.size(); current++){
+      for(auto const alph : minimal.alphabet){
+        for(auto const &transition : minimal.transitions[order[current]]){
+          if(transition.alpha == alph && renumbered[transition.to] == -1){
+            renumbered[transition.to] = (int)order.size();
+            order.push_back(transition.to);
+          }
+        }
+      }
+    }
+
+    Automaton canonical;
+    canonical.alphabet = minimal.alphabet;
+    for(std::size_t state = 0; state < order.size(); state++){
+      canonical.appendState((int)state, state == 0, minimal.final_states.test(order[state]));
+    }
+    for(std::size_t state = 0; state < order.size(); state++){
+      for(auto const alph : minimal.alphabet){
+        for(auto const &transition : minimal.transitions[order[state]]){
+          if(transition.alpha == alph){
+            canonical.appendTransition((int)state, alph, renumbered[transition.to]);
+          }
+        }
+      }
+    }
+    return canonical;
+  }
+
+  /**
+   * @brief Private function that writes a canonical automaton as bytes : the alphabet, then for each state if it is final and its successor for each letter
+   * (Used for languageHash())
+   * @return std::string the bytes
+   */
+  std::string Automaton::canonicalBytes() const{
+    std::string bytes;
+    appendBytes(bytes, (std::uint32_t)alphabet.size());
+    bytes.append(alphabet.begin(), alphabet.end());
+    appendBytes(bytes, (std::uint32_t)values.size());
+    for(std::size_t index = 0; index < values.size(); index++){
+      bytes.push_back(final_states.test(index) ? 1 : 0);
+      for(auto const alph : alphabet){
+        for(auto const &transition : transitions[index]){
+          if(transition.alpha == alph){
+            appendBytes(bytes, (std::uint32_t)values[transition.to]);
+          }
+        }
+      }
+    }
+    return bytes;
+  }
+
+  /**
+   * @brief Compute a hash of 128 bits of the language of the current automaton, from its canonical form
+   * 
+   * @return Hash128 the hash, the same for all the automata with the same alphabet and the same language
+   */
+  Hash128 Automaton::languageHash() const{
+    assert(isValid());
+    return hashBytes(createCanonical(*this).canonicalBytes());
+  }
+
+  // ------------------- 15 Cache des transformations
+  namespace {
+    // The installed cache, and the number of tickets of each cache, are guarded by installMutex
+    std::mutex installMutex;
+    std::condition_variable ticketReleased;
+    OperationCache* installedCache = nullptr;
+  }
+
+  /**
+   * @brief Private function that writes the alphabet, the states with their properties and the sorted transitions of the current automaton as bytes
+   * (Used for OperationCache)
+   * @return std::string the bytes, the same for two automata with the same states and transitions
+   */
+  std::string Automaton::structuralBytes() const{
+    std::string bytes;
+    appendBytes(bytes, (std::uint32_t)alphabet.size());
+    bytes.append(alphabet.begin(), alphabet.end());
+    // The states and the transitions are sorted by number, so the order in which they were added doesn't matter
+    std::vector<int> sorted(values.size());
+    for(std::size_t index = 0; index < values.size(); index++){
+      sorted[index] = (int)index;
+    }
+    std::sort(sorted.begin(), sorted.end(), [this](int lhs, int rhs){
+      return values[lhs] < values[rhs];
+    });
+    appendBytes(bytes, (std::uint32_t)sorted.size());
+    for(auto const index : sorted){
+      appendBytes(bytes, (std::uint32_t)values[index]);
+      bytes.push_back((char)((initial_states.test(index) ? 1 : 0) | (final_states.test(index) ? 2 : 0)));
+    }
+    std::vector<std::tuple<int, char, int>> arcs;
+    for(std::size_t index = 0; index < values.size(); index++){
+      for(auto const &transition : transitions[index]){
+        arcs.emplace_back(values[index], transition.alpha, values[transition.to]);
+      }
+    }
+    std::sort(arcs.begin(), arcs.end());
+    for(auto const &arc : arcs){
+      appendBytes(bytes, (std::uint32_t)std::get<0>(arc));
+      bytes.push_back(std::get<1>(arc));
+      appendBytes(bytes, (std::uint32_t)std::get<2>(arc));
+    }
+    return bytes;
+  }
+
+  /**
+   * @brief Private function that hashes the structural bytes of the current automaton
+   * (Used for OperationCache)
+   * @return Hash128 the hash, the same for two automata with the same states and transitions
+   */
+  Hash128 Automaton::structuralHash() const{
+    return hashBytes(structuralBytes());
+  }
+
+  /**
+   * @brief Build an empty cache
+   * 
+   * @param maxBytes the approximate memory that the results in the cache can use
+   */
+  OperationCache::OperationCache(std::size_t maxBytes)
+  : maxBytes(maxBytes), bytes(0), hits(0), misses(0), tickets(0)
+  {
+  }
+
+  /**
+   * @brief Use a cache in the transformations of all the automata, once the transformations using the previous cache are over
+   * 
+   * @param cache the cache to use, or nullptr to stop using a cache
+   */
+  void OperationCache::install(OperationCache* cache){
+    std::unique_lock<std::mutex> lock(installMutex);
+    OperationCache* previous = installedCache;
+    installedCache = cache;
+    if(previous != nullptr && previous != cache){
+      ticketReleased.wait(lock, [previous]{
+        return previous->tickets == 0;
+      });
+    }
+  }
+
+  /**
+   * @brief Give the cache used by the transformations
+   * 
+   * @return the installed cache, or nullptr if there is none
+   */
+  OperationCache* OperationCache::installed(){
+    std::lock_guard<std::mutex> lock(installMutex);
+    return installedCache;
+  }
+
+  /**
+   * @brief Release the cache of the ticket, which can then be uninstalled
+   */
+  OperationCache::Ticket::~Ticket(){
+    if(cache != nullptr){
+      std::lock_guard<std::mutex> lock(installMutex);
+      if(--cache->tickets == 0){
+        ticketReleased.notify_all();
+      }
+    }
+  }
+
+  /**
+   * @brief Remove all the results of the cache
+   * 
+   */
+  void OperationCache::clear(){
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+    bytes = 0;
+  }
+
+  /**
+   * @brief Count the results in the cache
+   */
+  std::size_t OperationCache::countEntries() const{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+  }
+
+  /**
+   * @brief Give the approximate memory used by the results in the cache
+   */
+  std::size_t OperationCache::countBytes() const{
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytes;
+  }
+
+  /**
+   * @brief Count the results that have been found in the cache
+   */
+  std::size_t OperationCache::countHits() const{
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+  }
+
+  /**
+   * @brief Count the results that were not in the cache
+   */
+  std::size_t OperationCache::countMisses() const{
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+  }
+
+  /**
+   * @brief Private function that looks for a result in the installed cache, and marks it as the most recently used
+   * (Used for createDeterministic(), createComplement() and createMinimalMoore())
+   * @param operation the transformation
+   * @param automaton the transformed automaton
+   * @param ticket receives the installed cache, and the bytes and the hash of the automaton if there is a cache
+   * @param result receives the result if it is in the cache
+   * @return true if the result has been found
+   * @return false if there is no cache or if the result isn't in it
+   */
+  bool OperationCache::lookup(Operation operation, const Automaton& automaton, Ticket& ticket, Automaton& result){
+    assert(ticket.cache == nullptr);
+    OperationCache* cache;
+    {
+      std::lock_guard<std::mutex> lock(installMutex);
+      cache = installedCache;
+      if(cache == nullptr){
+        return false;
+      }
+      cache->tickets++;
+      ticket.cache = cache;
+    }
+    ticket.input = automaton.structuralBytes();
+    ticket.key = hashBytes(ticket.input);
+
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    auto search = cache->index.find({operation, ticket.key});
+    // Two automata may have the same hash, so the result is only used for the same automaton
+    if(search == cache->index.end() || search->second->input != ticket.input){
+      cache->misses++;
+      return false;
+    }
+    cache->hits++;
+    cache->entries.splice(cache->entries.begin(), cache->entries, search->second);
+    result = search->second->result;
+    return true;
+  }
+
+  /**
+   * @brief Private function that stores a result in the cache used by the transformation, removing the least recently used results if the memory limit is reached
+   * (Used for createDeterministic(), createComplement() and createMinimalMoore())
+   * @param operation the transformation
+   * @param ticket the cache, the bytes and the hash of the transformed automaton, given by lookup(), the bytes being moved to the cache
+   * @param result the result of the transformation
+   */
+  void OperationCache::store(Operation operation, Ticket& ticket, const Automaton& result){
+    OperationCache* cache = ticket.cache;
+    if(cache == nullptr){
+      return;
+    }
+    const Hash128& key = ticket.key;
+    std::size_t resultBytes = result.memoryUsage().total() + sizeof(Entry) + ticket.input.capacity();
+    if(resultBytes > cache->maxBytes){
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    if(cache->index.find({operation, key}) != cache->index.end()){
+      return;
+    }
+    while(!cache->entries.empty() && cache->bytes + resultBytes > cache->maxBytes){
+      Entry &last = cache->entries.back();
+      cache->bytes -= last.bytes;
+      cache->index.erase({last.operation, last.key});
+      cache->entries.pop_back();
+    }
+    cache->entries.push_front(Entry{operation, key, std::move(ticket.input), result, resultBytes});
+    cache->index.insert({{operation, key}, cache->entries.begin()});
+    cache->bytes += resultBytes;
+  }
+
+  // ------------------- 16 Simulation bit-parallele
+  namespace {
+    /**
+     * @brief Compute the union of the masks of the states of the set, both being Words machine words long
+     * (Used for BitParallelMatcher)
+     */
+    template<std::size_t Words>
+    void unionOfMasks(const std::uint64_t* current, const std::uint64_t* successors, std::uint64_t* next){
+      std::fill(next, next + Words, 0);
+      for(std::size_t block = 0; block < Words; block++){
+        for(std::uint64_t bits = current[block]; bits != 0; bits &= bits - 1){
+          const std::uint64_t* mask = successors + (block * 64 + __builtin_ctzll(bits)) * Words;
+          for(std::size_t word = 0; word < Words; word++){
+            next[word] |= mask[word];
+          }
+        }
+      }
+    }
+
+#ifdef AUTOMATON_X86_KERNELS
+    /**
+     * @brief Compute the union of the masks of the states of the set, 4 machine words long, in an AVX2 register
+     * (Used for BitParallelMatcher)
+     */
+    __attribute__((target("avx2")))
+    void unionOfMasksAvx2(const std::uint64_t* current, const std::uint64_t* successors, std::uint64_t* next){
+      __m256i result = _mm256_setzero_si256();
+      for(std::size_t block = 0; block < 4; block++){
+        for(std::uint64_t bits = current[block]; bits != 0; bits &= bits - 1){
+          const std::uint64_t* mask = successors + (block * 64 + __builtin_ctzll(bits)) * 4;
+          result = _mm256_or_si256(result, _mm256_loadu_si256((const __m256i*)mask));
+        }
+      }
+      _mm256_storeu_si256((__m256i*)next, result);
+    }
+#endif
+  }
+
+  /**
+   * @brief Tell if the automaton is small enough for a BitParallelMatcher
+   * 
+   * @param automaton the automaton to simulate
+   * @return true if it has at most MaxStates states
+   */
+  bool BitParallelMatcher::fits(const Automaton& automaton){
+    return automaton.countStates() <= MaxStates;
+  }
+
+  /**
+   * @brief Precompute, for each letter used by a transition and each state, the mask of the successors
+   * 
+   * @param automaton the automaton to simulate, with at most MaxStates states
+   * @throw std::invalid_argument if the automaton has more than MaxStates states
+   */
+  BitParallelMatcher::BitParallelMatcher(const Automaton& automaton)
+  : states(automaton.countStates()), words(1), letters(UCHAR_MAX + 1, -1), hasAvx2(false)
+  {
+    assert(automaton.isValid());
+    if(!fits(automaton)){
+      throw std::invalid_argument("The automaton has more than " + std::to_string(MaxStates) + " states");
+    }
+    while(words * 64 < states){
+      words *= 2;
+    }
+#ifdef AUTOMATON_X86_KERNELS
+    hasAvx2 = words == 4 && __builtin_cpu_supports("avx2");
+#endif
+
+    int count = 0;
+    for(auto const &outgoing : automaton.transitions){
+      for(auto const &transition : outgoing){
+        if(letters[(unsigned char)transition.alpha] == -1){
+          letters[(unsigned char)transition.alpha] = count++;
+        }
+      }
+    }
+
+    masks.assign((std::size_t)count * states * words, 0);
+    for(std::size_t state = 0; state < states; state++){
+      for(auto const &transition : automaton.transitions[state]){
+        std::size_t letter = letters[(unsigned char)transition.alpha];
+        masks[(letter * states + state) * words + (transition.to >> 6)] |= std::uint64_t(1) << (transition.to & 63);
+      }
+    }
+
+    initials.assign(words, 0);
+    finals.assign(words, 0);
+    for(auto const index : automaton.initials){
+      initials[index >> 6] |= std::uint64_t(1) << (index & 63);
+    }
+    for(std::size_t word = 0; word < automaton.final_states.words.size(); word++){
+      finals[word] = automaton.final_states.words[word];
+    }
+  }
+
+  /**
+   * @brief Private function that reads the word, each letter being the union of the masks of the current states
+   * (Used for match())
+   * @param word the word to read
+   * @return true if a final state is reached
+   */
+  template<std::size_t Words>
+  bool BitParallelMatcher::matchWords(const std::string& word) const{
+    std::uint64_t current[Words];
+    std::uint64_t next[Words];
+    std::copy(initials.begin(), initials.end(), current);
+    for(auto const alpha : word){
+      int letter = letters[(unsigned char)alpha];
+      if(letter == -1){
+        return false;
+      }
+      const std::uint64_t* successors = masks.data() + (std::size_t)letter * states * Words;
+#ifdef AUTOMATON_X86_KERNELS
+      if(Words == 4 && hasAvx2){
+        unionOfMasksAvx2(current, successors, next);
+      }else{
+        unionOfMasks<Words>(current, successors, next);
+      }
+#else
+      unionOfMasks<Words>(current, successors, next);
+#endif
+      std::uint64_t reached = 0;
+      for(std::size_t block = 0; block < Words; block++){
+        reached |= next[block];
+      }
+      if(reached == 0){
+        return false;
+      }
+      std::copy(next, next + Words, current);
+    }
+    for(std::size_t block = 0; block < Words; block++){
+      if((current[block] & finals[block]) != 0){
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Tell if the word is accepted by the automaton
+   * 
+   * @param word the word to read
+   * @return true if the automaton accepts the word
+   * @return false if the automaton doesn't accept the word
+   */
+  bool BitParallelMatcher::match(const std::string& word) const{
+    switch(words){
+      case 1:
+        return matchWords<1>(word);
+      case 2:
+        return matchWords<2>(word);
+      default:
+        return matchWords<4>(word);
+    }
+  }
+
+  /**
+   * @brief Give the number of states of the automaton
+   * 
+   * @return std::size_t the number of states
+   */
+  std::size_t BitParallelMatcher::countStates() const{
+    return states;
+  }
+
+  // ------------------- 17 Lecture de plusieurs mots en parallele
+  namespace {
+    /**
+     * @brief Words read together, one per lane : the column of the letter read by each lane at each position
+     * (Used for DfaMatcher::matchMany())
+     * A lane whose word is over, or that has no word, reads the last column, where every state stays in place.
+     */
+    template<std::size_t Lanes>
+    struct LaneBatch{
+      const std::vector<std::string>& words;
+      const std::vector<std::int32_t>& columns;
+      std::int32_t stay;
+      std::size_t first;
+      std::size_t count;
+      std::size_t length;
+
+      LaneBatch(const std::vector<std::string>& words, const std::vector<std::int32_t>& columns, std::int32_t stay, std::size_t first)
+      : words(words), columns(columns), stay(stay), first(first), count(std::min(Lanes, words.size() - first)), length(0)
+      {
+        for(std::size_t lane = 0; lane < count; lane++){
+          length = std::max(length, words[first + lane].size());
+        }
+      }
+
+      void columnsAt(std::size_t position, std::int32_t* column) const{
+        for(std::size_t lane = 0; lane < Lanes; lane++){
+          column[lane] = stay;
+          if(lane < count && position < words[first + lane].size()){
+            column[lane] = columns[(unsigned char)words[first + lane][position]];
+          }
+        }
+      }
+    };
+
+    /**
+     * @brief Read the words by batches of Lanes words, with plain loads
+     * (Used for DfaMatcher::matchMany())
+     */
+    template<std::size_t Lanes>
+    void matchLanesScalar(const std::vector<std::string>& words, const std::vector<std::int32_t>& columns, const std::vector<std::int32_t>& next, std::size_t stride, std::int32_t initial, std::vector<std::int32_t>& ends){
+      for(std::size_t first = 0; first < words.size(); first += Lanes){
+        LaneBatch<Lanes> batch(words, columns, (std::int32_t)stride - 1, first);
+        std::int32_t state[Lanes];
+        std::int32_t column[Lanes];
+        std::fill(state, state + Lanes, initial);
+        for(std::size_t position = 0; position < batch.length; position++){
+          batch.columnsAt(position, column);
+          for(std::size_t lane = 0; lane < Lanes; lane++){
+            state[lane] = next[(std::size_t)state[lane] * stride + column[lane]];
+          }
+        }
+        std::copy(state, state + batch.count, ends.begin() + first);
+      }
+    }
+
+#ifdef AUTOMATON_X86_KERNELS
+    /**
+     * @brief Read the words by batches of 8 words, the transitions being loaded with an AVX2 gather
+     * (Used for DfaMatcher::matchMany())
+     */
+    __attribute__((target("avx2")))
+    void matchLanesAvx2(const std::vector<std::string>& words, const std::vector<std::int32_t>& columns, const std::vector<std::int32_t>& next, std::size_t stride, std::int32_t initial, std::vector<std::int32_t>& ends){
+      const __m256i strides = _mm256_set1_epi32((int)stride);
+      for(std::size_t first = 0; first < words.size(); first += 8){
+        LaneBatch<8> batch(words, columns, (std::int32_t)stride - 1, first);
+        alignas(32) std::int32_t column[8];
+        __m256i state = _mm256_set1_epi32(initial);
+        for(std::size_t position = 0; position < batch.length; position++){
+          batch.columnsAt(position, column);
+          __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(state, strides), _mm256_load_si256((const __m256i*)column));
+          state = _mm256_i32gather_epi32((const int*)next.data(), index, 4);
+        }
+        alignas(32) std::int32_t state_lanes[8];
+        _mm256_store_si256((__m256i*)state_lanes, state);
+        std::copy(state_lanes, state_lanes + batch.count, ends.begin() + first);
+      }
+    }
+
+    /**
+     * @brief Read the words by batches of 16 words, the transitions being loaded with an AVX-512 gather
+     * (Used for DfaMatcher::matchMany())
+     */
+    __attribute__((target("avx512f")))
+    void matchLanesAvx512(const std::vector<std::string>& words, const std::vector<std::int32_t>& columns, const std::vector<std::int32_t>& next, std::size_t stride, std::int32_t initial, std::vector<std::int32_t>& ends){
+      const __m512i strides = _mm512_set1_epi32((int)stride);
+      for(std::size_t first = 0; first < words.size(); first += 16){
+        LaneBatch<16> batch(words, columns, (std::int32_t)stride - 1, first);
+        alignas(64) std::int32_t column[16];
+        __m512i state = _mm512_set1_epi32(initial);
+        for(std::size_t position = 0; position < batch.length; position++){
+          batch.columnsAt(position, column);
+          __m512i index = _mm512_add_epi32(_mm512_mullo_epi32(state, strides), _mm512_load_si512((const void*)column));
+          // The masked form with a zero source, as the unmasked one reads an uninitialized source register
+          state = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, index, (const void*)next.data(), 4);
+        }
+        alignas(64) std::int32_t state_lanes[16];
+        _mm512_store_si512((void*)state_lanes, state);
+        std::copy(state_lanes, state_lanes + batch.count, ends.begin() + first);
+      }
+    }
+#endif
+  }
+
+  /**
+   * @brief Determinize the automaton and build its table, with a dead state for the missing transitions and the unknown letters
+   * 
+   * @param automaton the automaton to match
+   * @param limits the limits of the determinization
+   */
+  DfaMatcher::DfaMatcher(const Automaton& automaton, const Limits& limits)
+  : columns(UCHAR_MAX + 1, 0), stride(0), initial(0)
+  {
+    assert(automaton.isValid());
+    Automaton deterministic = Automaton::createDeterministic(automaton, limits);
+
+    // Column 0 is for the unknown letters, then one column per letter, and the last column keeps every state in place
+    std::vector<char> letters(deterministic.alphabet.begin(), deterministic.alphabet.end());
+    stride = letters.size() + 2;
+    for(std::size_t letter = 0; letter < letters.size(); letter++){
+      columns[(unsigned char)letters[letter]] = (std::int32_t)letter + 1;
+    }
+
+    std::size_t dead = deterministic.countStates();
+    std::size_t count = dead + 1;
+    if(count * stride > (std::size_t)std::numeric_limits<std::int32_t>::max()){
+      throw LimitExceeded(LimitExceeded::Reason::States, count);
+    }
+    next.assign(count * stride, (std::int32_t)dead);
+    finals.assign(count, 0);
+    for(std::size_t state = 0; state < count; state++){
+      next[state * stride + stride - 1] = (std::int32_t)state;
+    }
+    for(std::size_t state = 0; state < dead; state++){
+      for(auto const &transition : deterministic.transitions[state]){
+        if(transition.alpha != Epsilon){
+          next[state * stride + columns[(unsigned char)transition.alpha]] = transition.to;
+        }
+      }
+      finals[state] = deterministic.final_states.test(state) ? 1 : 0;
+    }
+    initial = deterministic.initials.empty() ? (std::int32_t)dead : deterministic.initials.front();
+  }
+
+  /**
+   * @brief Tell if the word is accepted by the automaton
+   * 
+   * @param word the word to read
+   * @return true if the automaton accepts the word
+   * @return false if the automaton doesn't accept the word
+   */
+  bool DfaMatcher::match(const std::string& word) const{
+    std::int32_t state = initial;
+    for(auto const alpha : word){
+      state = next[(std::size_t)state * stride + columns[(unsigned char)alpha]];
+    }
+    return finals[state] != 0;
+  }
+
+  /**
+   * @brief Tell, for each word, if it is accepted by the automaton, reading several words in lockstep
+   * 
+   * @param words the words to read
+   * @param accepted receives, for each word, true if it is accepted
+   * @param kernel the instruction set of the lanes, the scalar one being used if the processor doesn't support it
+   */
+  void DfaMatcher::matchMany(const std::vector<std::string>& words, std::vector<bool>& accepted, Kernel kernel) const{
+    if(kernel == Kernel::Automatic){
+      kernel = supports(Kernel::Avx512) ? Kernel::Avx512 : supports(Kernel::Avx2) ? Kernel::Avx2 : Kernel::Scalar;
+    }else if(!supports(kernel)){
+      kernel = Kernel::Scalar;
+    }
+
+    std::vector<std::int32_t> ends(words.size());
+    switch(kernel){
+#ifdef AUTOMATON_X86_KERNELS
+      case Kernel::Avx512:
+        matchLanesAvx512(words, columns, next, stride, initial, ends);
+        break;
+      case Kernel::Avx2:
+        matchLanesAvx2(words, columns, next, stride, initial, ends);
+        break;
+#endif
+      default:
+        matchLanesScalar<8>(words, columns, next, stride, initial, ends);
+        break;
+    }
+
+    accepted.resize(words.size());
+    for(std::size_t word = 0; word < words.size(); word++){
+      accepted[word] = finals[ends[word]] != 0;
+    }
+  }
+
+  /**
+   * @brief Tell if the processor supports the kernel
+   * 
+   * @param kernel the instruction set
+   * @return true if matchMany() can use it
+   */
+  bool DfaMatcher::supports(Kernel kernel){
+    switch(kernel){
+#ifdef AUTOMATON_X86_KERNELS
+      case Kernel::Avx2:
+        return __builtin_cpu_supports("avx2");
+      case Kernel::Avx512:
+        return __builtin_cpu_supports("avx512f");
+#else
+      case Kernel::Avx2:
+      case Kernel::Avx512:
+        return false;
+#endif
+      default:
+        return true;
+    }
+  }
+
+  /**
+   * @brief Give the number of states of the table
+   * 
+   * @return std::size_t the number of states, including the dead state
+   */
+  std::size_t DfaMatcher::countStates() const{
+    return finals.size();
+  }
+
+  // ------------------- 18 Lecture et ecriture de texte
+  namespace {
+    /**
+     * @brief Where the reading of a Ba text is, kept from a block of lines to the next one
+     * (Used for parseBa())
+     */
+    struct BaProgress{
+      bool isFirstLine = true;
+      bool hasFinals = false;
+    };
+
+    /**
+     * @brief Tokenizer that reads a text line by line, without copying it
+     * (Used for parse())
+     */
+    class Scanner{
+    public:
+      Scanner(std::string_view text, std::size_t firstLine)
+      : current(text.data()), end(text.data() + text.size()), line(firstLine)
+      {
+      }
+
+      /**
+       * @brief Give the number of the current line, from 1
+       */
+      std::size_t lineNumber() const{
+        return line;
+      }
+
+      /**
+       * @brief Skip the blank lines, and tell if there is still a line to read
+       */
+      bool nextLine(){
+        for(;;){
+          skipBlanks();
+          if(current == end){
+            return false;
+          }
+          if(*current != '\n'){
+            return true;
+          }
+          current++;
+          line++;
+        }
+      }
+
+      /**
+       * @brief Check that the line is over, and go to the next one
+       */
+      void endLine(){
+        skipBlanks();
+        if(current != end){
+          if(*current != '\n'){
+            fail("unexpected '" + std::string(1, *current) + "'");
+          }
+          current++;
+          line++;
+        }
+      }
+
+      bool atEndOfLine(){
+        skipBlanks();
+        return current == end || *current == '\n';
+      }
+
+      char peek() const{
+        return current == end ? '\n' : *current;
+      }
+
+      /**
+       * @brief Give the character after the next one, '\n' at the end of the text
+       */
+      char peekSecond() const{
+        return end - current < 2 ? '\n' : current[1];
+      }
+
+      void expect(char expected){
+        if(peek() != expected){
+          fail(std::string("expected '") + expected + "'");
+        }
+        current++;
+      }
+
+      /**
+       * @brief Read a state, a non-negative number
+       */
+      int readState(){
+        if(current == end || *current < '0' || *current > '9'){
+          fail("expected a state number");
+        }
+        long long state = 0;
+        while(current != end && *current >= '0' && *current <= '9'){
+          state = state * 10 + (*current - '0');
+          if(state > std::numeric_limits<int>::max()){
+            fail("state number too large");
+          }
+          current++;
+        }
+        return (int)state;
+      }
+
+      /**
+       * @brief Convert a token read by readToken() to a state
+       */
+      int stateOf(std::string_view token) const{
+        if(token.empty()){
+          fail("expected a state number");
+        }
+        long long state = 0;
+        for(auto const digit : token){
+          if(digit < '0' || digit > '9'){
+            fail("expected a state number");
+          }
+          state = state * 10 + (digit - '0');
+          if(state > std::numeric_limits<int>::max()){
+            fail("state number too large");
+          }
+        }
+        return (int)state;
+      }
+
+      /**
+       * @brief Read the characters up to the next blank
+       */
+      std::string_view readToken(){
+        skipBlanks();
+        const char* begin = current;
+        while(current != end && *current != ' ' && *current != '\t' && *current != '\r' && *current != '\n'){
+          current++;
+        }
+        return std::string_view(begin, current - begin);
+      }
+
+      /**
+       * @brief Check that the letter can be a symbol of an automaton
+       */
+      char checkLetter(char letter) const{
+        if(!isgraph(letter)){
+          fail("invalid letter");
+        }
+        return letter;
+      }
+
+      [[noreturn]] void fail(const std::string& message) const{
+        throw ParseError(line, message);
+      }
+
+    private:
+      const char* current;
+      const char* end;
+      std::size_t line;
+
+      void skipBlanks(){
+        while(current != end && (*current == ' ' || *current == '\t' || *current == '\r')){
+          current++;
+        }
+      }
+    };
+
+    /**
+     * @brief Read a state between brackets : "[0]"
+     * (Used for parseBa())
+     */
+    int readBracketedState(Scanner& scanner){
+      scanner.expect('[');
+      int state = scanner.readState();
+      scanner.expect(']');
+      return state;
+    }
+
+    /**
+     * @brief Read the Ba format : an optional first line with the initial state, the transitions, then the final states
+     * (Used for parse())
+     */
+    template<typename Sink>
+    void parseBa(Scanner& scanner, BaProgress& progress, Sink& sink){
+      while(scanner.nextLine()){
+        // "[,[0]->[1]" is a transition with the letter '[', not a state
+        if(scanner.peek() == '[' && scanner.peekSecond() != ','){
+          int state = readBracketedState(scanner);
+          if(progress.isFirstLine){
+            sink.addInitial(state);
+          }else{
+            sink.addFinal(state);
+            progress.hasFinals = true;
+          }
+        }else{
+          if(progress.hasFinals){
+            scanner.fail("transition after the final states");
+          }
+          char alpha = scanner.checkLetter(scanner.peek());
+          scanner.expect(alpha);
+          scanner.expect(',');
+          int from = readBracketedState(scanner);
+          scanner.expect('-');
+          scanner.expect('>');
+          int to = readBracketedState(scanner);
+          sink.addTransition(from, alpha, to);
+        }
+        scanner.endLine();
+        progress.isFirstLine = false;
+      }
+    }
+
+    /**
+     * @brief Read the AT&T format : "from to letter [weight]" lines for the transitions, and "state [weight]" lines for the final states
+     * (Used for parse())
+     */
+    template<typename Sink>
+    void parseAtt(Scanner& scanner, Sink& sink){
+      while(scanner.nextLine()){
+        int first = scanner.readState();
+        if(scanner.atEndOfLine()){
+          sink.addFinal(first);
+          scanner.endLine();
+          continue;
+        }
+        std::string_view second = scanner.readToken();
+        if(scanner.atEndOfLine()){
+          // "state weight" : a final state with its weight
+          sink.addFinal(first);
+          scanner.endLine();
+          continue;
+        }
+        int to = scanner.stateOf(second);
+        std::string_view letter = scanner.readToken();
+        char alpha = Epsilon;
+        if(letter != "<eps>"){
+          if(letter.size() != 1){
+            scanner.fail("a letter must be a single character");
+          }
+          alpha = scanner.checkLetter(letter[0]);
+        }
+        if(!scanner.atEndOfLine()){
+          scanner.readToken();
+        }
+        sink.addTransition(first, alpha, to);
+        scanner.endLine();
+      }
+    }
+  }
+
+  /**
+   * @brief Builds the automaton while the text is read, block of whole lines after block of whole lines
+   * (Used for parse())
+   */
+  struct Automaton::TextReader{
+    Format format;
+    Automaton automaton;
+    std::vector<int> dense; // dense[state] : index of the small states, -1 if not seen yet
+    std::vector<bool> seen = std::vector<bool>(UCHAR_MAX + 1, false);
+    bool hasInitial = false;
+    std::size_t line = 1;
+    BaProgress progress;
+
+    /**
+     * Transition read, between dense indexes
+     */
+    struct Arc{
+      int from;
+      Transition transition;
+    };
+    std::vector<Arc> arcs; // Appended in the order of the text, then moved to the states with their exact size
+
+    explicit TextReader(Format textFormat)
+    : format(textFormat)
+    {
+    }
+
+    /**
+     * @brief Give the index of a state, added if needed
+     *
+     * The states are usually numbered from 0, so the small ones are found in a table and not in the hash map
+     */
+    int indexOf(int state){
+      if((std::size_t)state < dense.size() && dense[state] >= 0){
+        return dense[state];
+      }
+      // A large state may have been added before the table grew
+      auto search = automaton.indexes.find(state);
+      int index = search != automaton.indexes.end() ? search->second : automaton.appendState(state, false, false);
+      if((std::size_t)state >= dense.size() && (std::size_t)state < 4 * automaton.values.size() + 65536){
+        dense.resize(std::max((std::size_t)state + 1, 2 * dense.size()), -1);
+      }
+      if((std::size_t)state < dense.size()){
+        dense[state] = index;
+      }
+      return index;
+    }
+
+    void addInitial(int state){
+      automaton.setIndexInitial(indexOf(state));
+      hasInitial = true;
+    }
+
+    void addFinal(int state){
+      automaton.final_states.insert(indexOf(state));
+    }
+
+    void addTransition(int from, char alpha, int to){
+      // Without a line for it, the origin of the first transition is the initial state
+      if(!hasInitial){
+        addInitial(from);
+      }
+      int fromIndex = indexOf(from);
+      int toIndex = indexOf(to);
+      arcs.push_back(Arc{fromIndex, Transition{alpha, toIndex}});
+      if(alpha != Epsilon && !seen[(unsigned char)alpha]){
+        seen[(unsigned char)alpha] = true;
+        automaton.alphabet.insert(alpha);
+      }
+    }
+
+    /**
+     * @brief Read whole lines, the last one may miss its '\n' only at the end of the text
+     */
+    void read(std::string_view lines){
+      Scanner scanner(lines, line);
+      if(format == Format::Ba){
+        parseBa(scanner, progress, *this);
+      }else{
+        parseAtt(scanner, *this);
+      }
+      line = scanner.lineNumber();
+    }
+
+    /**
+     * @brief Give its transitions to each state, remove the transitions written on several lines, and give the automaton
+     */
+    Automaton finish(){
+      std::vector<std::size_t> counts(automaton.values.size(), 0);
+      for(auto const &arc : arcs){
+        counts[arc.from]++;
+      }
+      for(std::size_t index = 0; index < counts.size(); index++){
+        automaton.transitions[index].reserve(counts[index]);
+      }
+      for(auto const &arc : arcs){
+        automaton.transitions[arc.from].push_back(arc.transition);
+      }
+      std::vector<Arc>().swap(arcs);
+
+      for(auto &outgoing : automaton.transitions){
+        if(outgoing.size() > 1){
+          std::sort(outgoing.begin(), outgoing.end(), [](const Transition& lhs, const Transition& rhs){
+            return lhs.alpha != rhs.alpha ? lhs.alpha < rhs.alpha : lhs.to < rhs.to;
+          });
+          outgoing.erase(std::unique(outgoing.begin(), outgoing.end(), [](const Transition& lhs, const Transition& rhs){
+            return lhs.alpha == rhs.alpha && lhs.to == rhs.to;
+          }), outgoing.end());
+        }
+        automaton.transition_count += outgoing.size();
+      }
+      return std::move(automaton);
+    }
+  };
+
+  ParseError::ParseError(std::size_t line, const std::string& message)
+  : std::runtime_error("line " + std::to_string(line) + " : " + message), errorLine(line)
+  {
+  }
+
+  /**
+   * @brief Give the number of the line of the error
+   * 
+   * @return std::size_t the line, from 1
+   */
+  std::size_t ParseError::line() const{
+    return errorLine;
+  }
+
+  /**
+   * @brief Read an automaton in a text format, the states and the transitions being added while the lines are read
+   * 
+   * @param text the text to read
+   * @param format the format of the text
+   * @return the automaton
+   */
+  Automaton Automaton::parse(std::string_view text, Format format){
+    TextReader reader(format);
+    reader.read(text);
+    return reader.finish();
+  }
+
+  /**
+   * @brief Read an automaton in a text format from the whole stream, by blocks of whole lines
+   * 
+   * @param in the stream to read
+   * @param format the format of the text
+   * @return the automaton
+   */
+  Automaton Automaton::parse(std::istream& in, Format format){
+    TextReader reader(format);
+    std::vector<char> block(1 << 20);
+    std::size_t kept = 0; // The beginning of a line, read with the previous block
+    for(;;){
+      if(kept == block.size()){
+        block.resize(2 * block.size());
+      }
+      in.read(block.data() + kept, (std::streamsize)(block.size() - kept));
+      std::size_t size = kept + (std::size_t)in.gcount();
+      if(size == kept){
+        break;
+      }
+      std::size_t lineEnd = size;
+      while(lineEnd > 0 && block[lineEnd - 1] != '\n'){
+        lineEnd--;
+      }
+      reader.read(std::string_view(block.data(), lineEnd));
+      std::copy(block.begin() + lineEnd, block.begin() + size, block.begin());
+      kept = size - lineEnd;
+    }
+    reader.read(std::string_view(block.data(), kept));
+    return reader.finish();
+  }
+
+  /**
+   * @brief Write the automaton in a text format : the initial state first, then the transitions, then the final states
+   * 
+   * @param os where the function should write the automaton
+   * @param format the format of the text
+   * @return true if the automaton has been written
+   * @return false if the format cannot express the automaton
+   */
+  bool Automaton::write(std::ostream& os, Format format) const{
+    if(initials.size() != 1){
+      return false;
+    }
+    int initial = initials.front();
+    if(format == Format::Att && transitions[initial].empty()){
+      return false;
+    }
+    if(format == Format::Ba && hasEpsilonTransition()){
+      return false;
+    }
+    // The alphabet is only written through the transitions
+    std::vector<bool> used(UCHAR_MAX + 1, false);
+    for(auto const &outgoing : transitions){
+      for(auto const &transition : outgoing){
+        used[(unsigned char)transition.alpha] = true;
+      }
+    }
+    for(auto const alpha : alphabet){
+      if(!used[(unsigned char)alpha]){
+        return false;
+      }
+    }
+
+    BufferedWriter out(os, 0);
+    auto writeTransition = [&](int from, const Transition& transition){
+      if(format == Format::Ba){
+        out << transition.alpha << ",[" << values[from] << "]->[" << values[transition.to] << "]\n";
+      }else{
+        out << values[from] << " " << values[transition.to] << " ";
+        if(transition.alpha == Epsilon){
+          out << "<eps>\n";
+        }else{
+          out << transition.alpha << "\n";
+        }
+      }
+    };
+
+    if(format == Format::Ba){
+      out << "[" << values[initial] << "]\n";
+    }
+    for(auto const &transition : transitions[initial]){
+      writeTransition(initial, transition);
+    }
+    for(std::size_t index = 0; index < values.size(); index++){
+      if((int)index != initial){
+        for(auto const &transition : transitions[index]){
+          writeTransition((int)index, transition);
+        }
+      }
+    }
+    for(std::size_t index = 0; index < values.size(); index++){
+      if(final_states.test(index)){
+        if(format == Format::Ba){
+          out << "[" << values[index] << "]\n";
+        }else{
+          out << values[index] << "\n";
+        }
+      }
+    }
+    return true;
+  }
+
+  // ------------------- 19 Generation de code C++
+  namespace {
+    /**
+     * @brief Writes a letter as a C++ character literal
+     * (Used for emitCpp())
+     */
+    std::string cppLiteral(char alpha){
+      if(alpha == '\'' || alpha == '\\'){
+        return std::string{'\'', '\\', alpha, '\''};
+      }
+      return std::string{'\'', alpha, '\''};
+    }
+  }
+
+  /**
+   * @brief Write a C++ source that matches the language of the current automaton, from its canonical form
+   * 
+   * The states that cannot reach a final state are dropped : reaching one of them rejects the word at once.
+   * @param os where the function should write the source
+   * @param options the style of the code, the name of the function and its namespace
+   */
+  void Automaton::emitCpp(std::ostream& os, const EmitOptions& options) const{
+    assert(isValid());
+    Automaton canonical = createCanonical(*this);
+    IndexSet alive = canonical.coAccessibleIndexes();
+
+    // The alive states keep their breadth-first order, the initial one being 0
+    std::vector<int> number(canonical.values.size(), -1);
+    int count = 0;
+    for(std::size_t index = 0; index < canonical.values.size(); index++){
+      if(alive.test(index)){
+        number[index] = count++;
+      }
+    }
+    std::vector<char> letters(canonical.alphabet.begin(), canonical.alphabet.end());
+    const std::string& name = options.functionName;
+    std::string indent = options.namespaceName.empty() ? "" : "  ";
+
+    BufferedWriter out(os, 0);
+    out << "// Generated matcher : " << count << " states, " << (int)letters.size() << " letters\n";
+    out << "#include <string_view>\n\n";
+    if(!options.namespaceName.empty()){
+      out << "namespace " << options.namespaceName << " {\n\n";
+    }
+
+    if(count == 0){
+      out << indent << "inline bool " << name << "(std::string_view) {\n";
+      out << indent << "  return false;\n";
+      out << indent << "}\n";
+    }else if(options.style == EmitOptions::Style::Switch){
+      out << indent << "inline bool " << name << "(std::string_view word) {\n";
+      out << indent << "  int state = 0;\n";
+      out << indent << "  for (char letter : word) {\n";
+      out << indent << "    switch (state) {\n";
+      for(std::size_t index = 0; index < canonical.values.size(); index++){
+        if(number[index] == -1){
+          continue;
+        }
+        out << indent << "      case " << number[index] << ":\n";
+        out << indent << "        switch (letter) {\n";
+        for(auto const &transition : canonical.transitions[index]){
+          if(number[transition.to] != -1){
+            out << indent << "          case " << cppLiteral(transition.alpha) << ": state = " << number[transition.to] << "; break;\n";
+          }
+        }
+        out << indent << "          default: return false;\n";
+        out << indent << "        }\n";
+        out << indent << "        break;\n";
+      }
+      out << indent << "    }\n";
+      out << indent << "  }\n";
+      out << indent << "  switch (state) {\n";
+      for(std::size_t index = 0; index < canonical.values.size(); index++){
+        if(number[index] != -1 && canonical.final_states.test(index)){
+          out << indent << "    case " << number[index] << ":\n";
+        }
+      }
+      out << indent << "      return true;\n";
+      out << indent << "    default:\n";
+      out << indent << "      return false;\n";
+      out << indent << "  }\n";
+      out << indent << "}\n";
+    }else{
+      // Column 0 is for the unknown letters, and -1 rejects the word
+      std::string type = count < std::numeric_limits<short>::max() ? "short" : "int";
+      std::size_t width = letters.size() + 1;
+      out << indent << "constexpr unsigned char " << name << "_columns[256] = {";
+      for(int alpha = 0; alpha <= UCHAR_MAX; alpha++){
+        auto letter = std::lower_bound(letters.begin(), letters.end(), (char)alpha);
+        int column = letter != letters.end() && *letter == (char)alpha ? (int)(letter - letters.begin()) + 1 : 0;
+        out << (alpha % 32 == 0 ? "\n" + indent + "  " : "") << column << ",";
+      }
+      out << "\n" << indent << "};\n\n";
+      out << indent << "constexpr " << type << " " << name << "_next[" << count << "][" << (int)width << "] = {\n";
+      for(std::size_t index = 0; index < canonical.values.size(); index++){
+        if(number[index] == -1){
+          continue;
+        }
+        std::vector<int> row(width, -1);
+        for(auto const &transition : canonical.transitions[index]){
+          std::size_t column = std::lower_bound(letters.begin(), letters.end(), transition.alpha) - letters.begin() + 1;
+          row[column] = number[transition.to];
+        }
+        out << indent << "  {";
+        for(std::size_t column = 0; column < width; column++){
+          out << (column == 0 ? "" : ", ") << row[column];
+        }
+        out << "},\n";
+      }
+      out << indent << "};\n\n";
+      out << indent << "constexpr bool " << name << "_finals[" << count << "] = {";
+      for(std::size_t index = 0; index < canonical.values.size(); index++){
+        if(number[index] != -1){
+          out << (number[index] % 32 == 0 ? "\n" + indent + "  " : "") << (canonical.final_states.test(index) ? "true" : "false") << ",";
+        }
+      }
+      out << "\n" << indent << "};\n\n";
+      out << indent << "inline bool " << name << "(std::string_view word) {\n";
+      out << indent << "  int state = 0;\n";
+      out << indent << "  for (char letter : word) {\n";
+      out << indent << "    state = " << name << "_next[state][" << name << "_columns[(unsigned char)letter]];\n";
+      out << indent << "    if (state < 0) {\n";
+      out << indent << "      return false;\n";
+      out << indent << "    }\n";
+      out << indent << "  }\n";
+      out << indent << "  return " << name << "_finals[state];\n";
+      out << indent << "}\n";
+    }
+
+    if(!options.namespaceName.empty()){
+      out << "\n}\n";
+    }
+  }
+
+  // ------------------- 20 Automate sur un grand alphabet
+  namespace {
+    /**
+     * @brief Order of the transitions of a state : by symbol, then by target
+     * (Used for TokenAutomaton)
+     */
+    template<typename Transition>
+    bool isTransitionBefore(const Transition& lhs, const Transition& rhs){
+      return lhs.symbol != rhs.symbol ? lhs.symbol < rhs.symbol : lhs.to < rhs.to;
+    }
+
+    /**
+     * @brief Give the dense index of a state, or -1 if there is no such state
+     * (Used for TokenAutomaton and SymbolicAutomaton)
+     */
+    int denseIndexOf(const std::unordered_map<int, int>& indexes, int state){
+      auto search = indexes.find(state);
+      return search == indexes.end() ? -1 : search->second;
+    }
+
+    /**
+     * @brief Add a state at the end of the dense storage, and give its index
+     * (Used for TokenAutomaton and SymbolicAutomaton)
+     */
+    template<typename Transition>
+    int appendDenseState(std::vector<int>& values, std::unordered_map<int, int>& indexes, std::vector<bool>& initialStates, std::vector<bool>& finalStates,
+        std::vector<std::vector<Transition>>& transitions, int state, bool isInitial, bool isFinal){
+      int index = (int)values.size();
+      values.push_back(state);
+      indexes.insert({state, index});
+      initialStates.push_back(isInitial);
+      finalStates.push_back(isFinal);
+      transitions.emplace_back();
+      return index;
+    }
+
+    /**
+     * @brief Give the dense indexes of the initial states, in increasing order
+     * (Used for TokenAutomaton and SymbolicAutomaton)
+     */
+    std::vector<int> initialIndexes(const std::vector<bool>& initialStates){
+      std::vector<int> initials;
+      for(std::size_t index = 0; index < initialStates.size(); index++){
+        if(initialStates[index]){
+          initials.push_back((int)index);
+        }
+      }
+      return initials;
+    }
+
+    /**
+     * @brief Tell if no final state can be reached from an initial state, by a depth-first search
+     * (Used for TokenAutomaton::isLanguageEmpty() and SymbolicAutomaton::isLanguageEmpty())
+     */
+    template<typename Transition>
+    bool isLanguageEmptyOf(const std::vector<bool>& initialStates, const std::vector<bool>& finalStates, const std::vector<std::vector<Transition>>& transitions){
+      std::vector<bool> seen(initialStates.size(), false);
+      std::vector<int> stack = initialIndexes(initialStates);
+      for(auto const index : stack){
+        seen[index] = true;
+      }
+      while(!stack.empty()){
+        int index = stack.back();
+        stack.pop_back();
+        if(finalStates[index]){
+          return false;
+        }
+        for(auto const &transition : transitions[index]){
+          if(!seen[transition.to]){
+            seen[transition.to] = true;
+            stack.push_back(transition.to);
+          }
+        }
+      }
+      return true;
+    }
+
+    /**
+     * @brief Give the useful states : reachable from the initial state, and reaching a final state
+     * (Used for TokenAutomaton::createMinimal() and SymbolicAutomaton::createMinimal())
+     */
+    template<typename Transition>
+    std::vector<bool> usefulStates(int initial, const std::vector<bool>& finalStates, const std::vector<std::vector<Transition>>& transitions){
+      std::size_t count = transitions.size();
+      std::vector<bool> accessible(count, false);
+      std::vector<int> stack{initial};
+      accessible[initial] = true;
+      while(!stack.empty()){
+        int index = stack.back();
+        stack.pop_back();
+        for(auto const &transition : transitions[index]){
+          if(!accessible[transition.to]){
+            accessible[transition.to] = true;
+            stack.push_back(transition.to);
+          }
+        }
+      }
+      std::vector<std::vector<int>> predecessors(count);
+      for(std::size_t index = 0; index < count; index++){
+        for(auto const &transition : transitions[index]){
+          predecessors[transition.to].push_back((int)index);
+        }
+      }
+      std::vector<bool> alive(count, false);
+      for(std::size_t index = 0; index < count; index++){
+        if(accessible[index] && finalStates[index]){
+          alive[index] = true;
+          stack.push_back((int)index);
+        }
+      }
+      while(!stack.empty()){
+        int index = stack.back();
+        stack.pop_back();
+        for(auto const from : predecessors[index]){
+          if(accessible[from] && !alive[from]){
+            alive[from] = true;
+            stack.push_back(from);
+          }
+        }
+      }
+      return alive;
+    }
+
+    /**
+     * @brief Numbers the subsets of states of a subset construction in the order they are found
+     * (Used for TokenAutomaton::createDeterministic() and SymbolicAutomaton::createDeterministic())
+     */
+    class SubsetNumbers{
+    public:
+      std::vector<std::vector<int>> subsets; // subsets[number] : sorted dense indexes of the states of the subset
+
+      /**
+       * @brief Give the number of a subset, or -1 if it hasn't been added
+       */
+      int find(const std::vector<int>& subset) const{
+        auto search = numbers.find(subset);
+        return search == numbers.end() ? -1 : search->second;
+      }
+
+      /**
+       * @brief Add a new subset, final if one of its states is, and call addState(number, isFinal) to add its state
+       */
+      template<typename AddState>
+      int add(std::vector<int>&& subset, const std::vector<bool>& finalStates, Budget& budget, AddState&& addState){
+        budget.addState(StateBytes + sizeof(std::vector<int>) + NodeOverhead + subset.size() * sizeof(int));
+        int nb = (int)subsets.size();
+        bool isFinal = false;
+        for(auto const index : subset){
+          if(finalStates[index]){
+            isFinal = true;
+          }
+        }
+        addState(nb, isFinal);
+        numbers.insert({subset, nb});
+        subsets.push_back(std::move(subset));
+        return nb;
+      }
+
+    private:
+      std::unordered_map<std::vector<int>, int, SubsetHash> numbers;
+    };
+
+    /**
+     * @brief Numbers the pairs of states of a product in the order they are found
+     * (Used for TokenAutomaton::createProduct() and SymbolicAutomaton::createProduct())
+     */
+    class PairNumbers{
+    public:
+      std::vector<std::pair<int, int>> pairs; // pairs[number] : dense indexes of the left and the right states
+
+      /**
+       * @brief Give the number of a pair, calling addState(number, left, right) to add its state if it is new
+       */
+      template<typename AddState>
+      int numberOf(int left, int right, Budget& budget, AddState&& addState){
+        auto inserted = ids.insert({(std::uint64_t)left << 32 | (std::uint32_t)right, (int)pairs.size()});
+        if(inserted.second){
+          budget.addState(StateBytes + 2 * sizeof(int));
+          addState((int)pairs.size(), left, right);
+          pairs.push_back({left, right});
+        }
+        return inserted.first->second;
+      }
+
+      /**
+       * @brief Add the pairs of initial states, and give their numbers
+       */
+      template<typename AddState>
+      std::vector<int> addInitials(const std::vector<bool>& leftInitials, const std::vector<bool>& rightInitials, Budget& budget, AddState&& addState){
+        std::vector<int> rights = initialIndexes(rightInitials);
+        std::vector<int> numbers;
+        for(auto const left : initialIndexes(leftInitials)){
+          for(auto const right : rights){
+            numbers.push_back(numberOf(left, right, budget, addState));
+          }
+        }
+        return numbers;
+      }
+
+    private:
+      std::unordered_map<std::uint64_t, int> ids;
+    };
+  }
+
+  /**
+   * @brief Build an empty automaton
+   */
+  TokenAutomaton::TokenAutomaton()
+  : transition_count(0)
+  {
+  }
+
+  /**
+   * @brief Build the automaton over 32-bit symbols equivalent to an automaton over characters
+   *
+   * @param automaton an automaton without epsilon-transition
+   * @return TokenAutomaton with the same states, each letter becoming the symbol of its byte value
+   */
+  TokenAutomaton TokenAutomaton::fromAutomaton(const Automaton& automaton){
+    assert(!automaton.hasEpsilonTransition());
+
+    TokenAutomaton tokens;
+    for(auto const alph : automaton.alphabet){
+      tokens.alphabet.push_back((unsigned char)alph);
+    }
+    std::sort(tokens.alphabet.begin(), tokens.alphabet.end());
+    for(std::size_t index = 0; index < automaton.values.size(); index++){
+      tokens.appendState(automaton.values[index], automaton.initial_states.test(index), automaton.final_states.test(index));
+    }
+    for(std::size_t index = 0; index < automaton.values.size(); index++){
+      auto &outgoing = tokens.transitions[index];
+      for(auto const &transition : automaton.transitions[index]){
+        outgoing.push_back(Transition{(unsigned char)transition.alpha, transition.to});
+      }
+      std::sort(outgoing.begin(), outgoing.end(), isTransitionBefore<Transition>);
+      tokens.transition_count += outgoing.size();
+    }
+    return tokens;
+  }
+
+  /**
+   * @brief Tell if the current automaton has at least one symbol and one state
+   */
+  bool TokenAutomaton::isValid() const{
+    return !alphabet.empty() && !values.empty();
+  }
+
+  /**
+   * @brief Add the symbol in the sorted alphabet if it isn't there
+   *
+   * @param symbol the symbol to add
+   * @return true if the symbol has been added
+   * @return false if the symbol was already there
+   */
+  bool TokenAutomaton::addSymbol(Symbol symbol){
+    auto position = std::lower_bound(alphabet.begin(), alphabet.end(), symbol);
+    if(position != alphabet.end() && *position == symbol){
+      return false;
+    }
+    alphabet.insert(position, symbol);
+    return true;
+  }
+
+  /**
+   * @brief Tell if the symbol is in the alphabet of the current automaton
+   */
+  bool TokenAutomaton::hasSymbol(Symbol symbol) const{
+    return std::binary_search(alphabet.begin(), alphabet.end(), symbol);
+  }
+
+  /**
+   * @brief Count the symbols of the current automaton
+   */
+  std::size_t TokenAutomaton::countSymbols() const{
+    return alphabet.size();
+  }
+
+  /**
+   * @brief Private function that gives the dense index of a state
+   * (Used for all the functions taking the number of a state)
+   * @param state the number of the state
+   * @return int the index of the state, or -1 if there is no such state
+   */
+  int TokenAutomaton::indexOf(int state) const{
+    return denseIndexOf(indexes, state);
+  }
+
+  /**
+   * @brief Private function that adds a state without checking it, and gives its dense index
+   * (Used for addState() and the transformations)
+   */
+  int TokenAutomaton::appendState(int state, bool isInitial, bool isFinal){
+    return appendDenseState(values, indexes, initial_states, final_states, transitions, state, isInitial, isFinal);
+  }
+
+  /**
+   * @brief Add the state if the current automaton hasn't it
+   *
+   * @param state the number of the state
+   * @return true if the state has been added
+   * @return false if the state is negative or already there
+   */
+  bool TokenAutomaton::addState(int state){
+    if(state < 0 || hasState(state)){
+      return false;
+    }
+    appendState(state, false, false);
+    return true;
+  }
+
+  /**
+   * @brief Tell if the current automaton has the state
+   */
+  bool TokenAutomaton::hasState(int state) const{
+    return state >= 0 && indexOf(state) != -1;
+  }
+
+  /**
+   * @brief Count the states of the current automaton
+   */
+  std::size_t TokenAutomaton::countStates() const{
+    return values.size();
+  }
+
+  /**
+   * @brief Make the state initial, if it exists
+   */
+  void TokenAutomaton::setStateInitial(int state){
+    int index = indexOf(state);
+    if(index != -1){
+      initial_states[index] = true;
+    }
+  }
+
+  /**
+   * @brief Tell if the state is initial
+   */
+  bool TokenAutomaton::isStateInitial(int state) const{
+    int index = indexOf(state);
+    return index != -1 && initial_states[index];
+  }
+
+  /**
+   * @brief Make the state final, if it exists
+   */
+  void TokenAutomaton::setStateFinal(int state){
+    int index = indexOf(state);
+    if(index != -1){
+      final_states[index] = true;
+    }
+  }
+
+  /**
+   * @brief Tell if the state is final
+   */
+  bool TokenAutomaton::isStateFinal(int state) const{
+    int index = indexOf(state);
+    return index != -1 && final_states[index];
+  }
+
+  /**
+   * @brief Add the transition at its place in the sorted transitions of its origin
+   *
+   * @param from the origin of the transition
+   * @param symbol the symbol of the transition
+   * @param to the target of the transition
+   * @return true if the transition has been added
+   * @return false if a state or the symbol is missing, or if the transition is already there
+   */
+  bool TokenAutomaton::addTransition(int from, Symbol symbol, int to){
+    int fromIndex = indexOf(from);
+    int toIndex = indexOf(to);
+    if(fromIndex == -1 || toIndex == -1 || !hasSymbol(symbol)){
+      return false;
+    }
+    auto &outgoing = transitions[fromIndex];
+    Transition transition{symbol, toIndex};
+    auto position = std::lower_bound(outgoing.begin(), outgoing.end(), transition, isTransitionBefore<Transition>);
+    if(position != outgoing.end() && position->symbol == symbol && position->to == toIndex){
+      return false;
+    }
+    outgoing.insert(position, transition);
+    transition_count++;
+    return true;
+  }
+
+  /**
+   * @brief Remove the transition if the current automaton has it
+   *
+   * @return true if the transition has been removed
+   * @return false if the transition wasn't there
+   */
+  bool TokenAutomaton::removeTransition(int from, Symbol symbol, int to){
+    int fromIndex = indexOf(from);
+    int toIndex = indexOf(to);
+    if(fromIndex == -1 || toIndex == -1){
+      return false;
+    }
+    auto &outgoing = transitions[fromIndex];
+    Transition transition{symbol, toIndex};
+    auto position = std::lower_bound(outgoing.begin(), outgoing.end(), transition, isTransitionBefore<Transition>);
+    if(position == outgoing.end() || position->symbol != symbol || position->to != toIndex){
+      return false;
+    }
+    outgoing.erase(position);
+    transition_count--;
+    return true;
+  }
+
+  /**
+   * @brief Tell if the current automaton has the transition
+   */
+  bool TokenAutomaton::hasTransition(int from, Symbol symbol, int to) const{
+    int fromIndex = indexOf(from);
+    int toIndex = indexOf(to);
+    if(fromIndex == -1 || toIndex == -1){
+      return false;
+    }
+    auto const &outgoing = transitions[fromIndex];
+    return std::binary_search(outgoing.begin(), outgoing.end(), Transition{symbol, toIndex}, isTransitionBefore<Transition>);
+  }
+
+  /**
+   * @brief Count the transitions of the current automaton
+   */
+  std::size_t TokenAutomaton::countTransitions() const{
+    return transition_count;
+  }
+
+  /**
+   * @brief Tell if the current automaton has one initial state and at most one transition per symbol from each state
+   */
+  bool TokenAutomaton::isDeterministic() const{
+    assert(isValid());
+    if(std::count(initial_states.begin(), initial_states.end(), true) != 1){
+      return false;
+    }
+    for(auto const &outgoing : transitions){
+      for(std::size_t i = 1; i < outgoing.size(); i++){
+        if(outgoing[i - 1].symbol == outgoing[i].symbol){
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Tell if no final state can be reached from an initial state
+   */
+  bool TokenAutomaton::isLanguageEmpty() const{
+    assert(isValid());
+    return isLanguageEmptyOf(initial_states, final_states, transitions);
+  }
+
+  namespace {
+    /**
+     * @brief Give the symbol read for an element of a word : itself for a symbol, its value for a byte
+     * (Used for TokenAutomaton::matchSymbols())
+     */
+    TokenAutomaton::Symbol symbolOf(TokenAutomaton::Symbol symbol){
+      return symbol;
+    }
+
+    TokenAutomaton::Symbol symbolOf(char byte){
+      return (unsigned char)byte;
+    }
+  }
+
+  /**
+   * @brief Private function that gives the sorted indexes reached from a set of indexes with a symbol
+   * (Used for matchSymbols())
+   * @param from the sorted indexes
+   * @param symbol the symbol read
+   * @param to receives the indexes reached, its memory being reused
+   */
+  void TokenAutomaton::successorsOf(const std::vector<int>& from, Symbol symbol, std::vector<int>& to) const{
+    to.clear();
+    for(auto const index : from){
+      auto const &outgoing = transitions[index];
+      auto first = std::lower_bound(outgoing.begin(), outgoing.end(), symbol, [](const Transition& transition, Symbol value){
+        return transition.symbol < value;
+      });
+      for(; first != outgoing.end() && first->symbol == symbol; ++first){
+        to.push_back(first->to);
+      }
+    }
+    std::sort(to.begin(), to.end());
+    to.erase(std::unique(to.begin(), to.end()), to.end());
+  }
+
+  /**
+   * @brief Private function that reads a word following all the paths at once, the sets of states being kept in two buffers
+   * (Used for match() and matchBytes())
+   * @param first the beginning of the word, symbols or bytes
+   * @param last the end of the word
+   * @return true if the word is accepted
+   */
+  template<typename Iterator>
+  bool TokenAutomaton::matchSymbols(Iterator first, Iterator last) const{
+    std::vector<int> current = initialIndexes(initial_states);
+    std::vector<int> next;
+    for(; first != last; ++first){
+      if(current.empty()){
+        return false;
+      }
+      successorsOf(current, symbolOf(*first), next);
+      current.swap(next);
+    }
+    for(auto const index : current){
+      if(final_states[index]){
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Tell if the word is accepted, following all the paths at once
+   *
+   * @param word the symbols of the word
+   * @return true if the word is accepted
+   */
+  bool TokenAutomaton::match(const std::vector<Symbol>& word) const{
+    assert(isValid());
+    return matchSymbols(word.begin(), word.end());
+  }
+
+  /**
+   * @brief Create a deterministic automaton with the subset construction
+   *
+   * The transitions of the states of a subset are merged and sorted by symbol, so only the symbols that
+   * have a transition are looked at, whatever the size of the alphabet.
+   * @param other the automaton to determinize
+   * @param limits the limits of the determinization
+   * @return a deterministic automaton, other itself if it is already deterministic
+   */
+  TokenAutomaton TokenAutomaton::createDeterministic(const TokenAutomaton& other, const Limits& limits){
+    assert(other.isValid());
+
+    Measure measure;
+    if(other.isDeterministic()){
+      return other;
+    }
+
+    Budget budget(limits);
+    TokenAutomaton deterministic;
+    deterministic.alphabet = other.alphabet;
+
+    SubsetNumbers numbers;
+    auto addState = [&](int nb, bool isFinal){
+      deterministic.appendState(nb, nb == 0, isFinal);
+    };
+    numbers.add(initialIndexes(other.initial_states), other.final_states, budget, addState);
+
+    std::vector<Transition> arcs;
+    std::vector<int> target;
+    for(std::size_t current = 0; current < numbers.subsets.size(); current++){
+      arcs.clear();
+      for(auto const index : numbers.subsets[current]){
+        arcs.insert(arcs.end(), other.transitions[index].begin(), other.transitions[index].end());
+      }
+      std::sort(arcs.begin(), arcs.end(), isTransitionBefore<Transition>);
+      for(std::size_t first = 0; first < arcs.size(); ){
+        Symbol symbol = arcs[first].symbol;
+        target.clear();
+        for(; first < arcs.size() && arcs[first].symbol == symbol; first++){
+          if(target.empty() || target.back() != arcs[first].to){
+            target.push_back(arcs[first].to);
+          }
+        }
+        budget.addTransition();
+        int to = numbers.find(target);
+        if(to == -1){
+          to = numbers.add(std::vector<int>(target), other.final_states, budget, addState);
+        }
+        deterministic.transitions[current].push_back(Transition{symbol, to});
+        deterministic.transition_count++;
+      }
+    }
+    if(measure.get() != nullptr){
+      measure.get()->subsetsCreated += numbers.subsets.size();
+    }
+    return deterministic;
+  }
+
+  /**
+   * @brief Create the synchronized product of two automata, the transitions of each pair of states being merged by symbol
+   *
+   * @param lhs the left hand automaton
+   * @param rhs the right hand automaton
+   * @param limits the limits of the product
+   * @return TokenAutomaton whose states are the reachable pairs of states, numbered in breadth-first order
+   */
+  TokenAutomaton TokenAutomaton::createProduct(const TokenAutomaton& lhs, const TokenAutomaton& rhs, const Limits& limits){
+    assert(lhs.isValid());
+    assert(rhs.isValid());
+
+    Measure measure;
+    Budget budget(limits);
+    TokenAutomaton product;
+    std::set_intersection(lhs.alphabet.begin(), lhs.alphabet.end(), rhs.alphabet.begin(), rhs.alphabet.end(), std::back_inserter(product.alphabet));
+
+    PairNumbers numbers;
+    auto addState = [&](int nb, int left, int right){
+      product.appendState(nb, false, lhs.final_states[left] && rhs.final_states[right]);
+    };
+    auto addPair = [&](int left, int right){
+      return numbers.numberOf(left, right, budget, addState);
+    };
+    for(auto const nb : numbers.addInitials(lhs.initial_states, rhs.initial_states, budget, addState)){
+      product.initial_states[nb] = true;
+    }
+
+    auto const &pairs = numbers.pairs;
+    for(std::size_t current = 0; current < pairs.size(); current++){
+      auto const &left = lhs.transitions[pairs[current].first];
+      auto const &right = rhs.transitions[pairs[current].second];
+      std::vector<Transition> outgoing;
+      std::size_t i = 0;
+      std::size_t j = 0;
+      while(i < left.size() && j < right.size()){
+        if(left[i].symbol < right[j].symbol){
+          i++;
+        }else if(right[j].symbol < left[i].symbol){
+          j++;
+        }else{
+          Symbol symbol = left[i].symbol;
+          std::size_t leftEnd = i;
+          std::size_t rightEnd = j;
+          while(leftEnd < left.size() && left[leftEnd].symbol == symbol){
+            leftEnd++;
+          }
+          while(rightEnd < right.size() && right[rightEnd].symbol == symbol){
+            rightEnd++;
+          }
+          for(std::size_t l = i; l < leftEnd; l++){
+            for(std::size_t r = j; r < rightEnd; r++){
+              outgoing.push_back(Transition{symbol, addPair(left[l].to, right[r].to)});
+              budget.addTransition();
+            }
+          }
+          i = leftEnd;
+          j = rightEnd;
+        }
+      }
+      std::sort(outgoing.begin(), outgoing.end(), isTransitionBefore<Transition>);
+      product.transition_count += outgoing.size();
+      product.transitions[current] = std::move(outgoing);
+    }
+    if(measure.get() != nullptr){
+      measure.get()->productPairs += pairs.size();
+    }
+
+    if(!product.isValid()){
+      if(product.alphabet.empty()){
+        product.alphabet.push_back(0);
+      }
+      if(product.values.empty()){
+        product.appendState(0, true, false);
+      }
+    }
+    return product;
+  }
+
+  /**
+   * @brief Create the minimal deterministic automaton with the algorithm of Moore, on the transitions that exist only
+   *
+   * The states that aren't reachable, or from which no final state can be reached, are removed first, so a missing
+   * transition leads to the implicit dead state, which isn't equivalent to any other state. The signature of a state
+   * is then its class and the classes of its successors, symbol by symbol. The classes are numbered in breadth-first order.
+   * @param other the automaton to minimize
+   * @param limits the limits of the determinization and of the refinement rounds
+   * @return TokenAutomaton the minimal automaton, with one non final state if the language is empty
+   */
+  TokenAutomaton TokenAutomaton::createMinimal(const TokenAutomaton& other, const Limits& limits){
+    assert(other.isValid());
+
+    Measure measure;
+    TokenAutomaton deterministic = createDeterministic(other, limits);
+    Budget budget(limits);
+    std::size_t count = deterministic.values.size();
+    int initial = (int)(std::find(deterministic.initial_states.begin(), deterministic.initial_states.end(), true) - deterministic.initial_states.begin());
+
+    std::vector<bool> alive = usefulStates(initial, deterministic.final_states, deterministic.transitions);
+
+    TokenAutomaton minimal;
+    minimal.alphabet = deterministic.alphabet;
+    if(!alive[initial]){
+      minimal.appendState(0, true, false);
+      return minimal;
+    }
+
+    // Congruence 0 : the non final states in class 0 and the final ones in class 1
+    std::vector<int> classes(count, -1);
+    for(std::size_t index = 0; index < count; index++){
+      if(alive[index]){
+        classes[index] = deterministic.final_states[index] ? 1 : 0;
+      }
+    }
+    std::size_t classCount = 0;
+    std::vector<std::int64_t> signature;
+    for(;;){
+      budget.poll();
+      if(measure.get() != nullptr){
+        measure.get()->refinementRounds++;
+      }
+
+      std::map<std::vector<std::int64_t>, int> numbers;
+      std::vector<int> next(count, -1);
+      for(std::size_t index = 0; index < count; index++){
+        if(!alive[index]){
+          continue;
+        }
+        signature.assign(1, classes[index]);
+        for(auto const &transition : deterministic.transitions[index]){
+          if(alive[transition.to]){
+            signature.push_back(transition.symbol);
+            signature.push_back(classes[transition.to]);
+          }
+        }
+        next[index] = numbers.insert({signature, (int)numbers.size()}).first->second;
+      }
+      classes.swap(next);
+      if(numbers.size() == classCount){
+        break;
+      }
+      classCount = numbers.size();
+    }
+
+    // One state per class, numbered in breadth-first order from the class of the initial state
+    std::vector<int> representative(classCount, -1);
+    for(std::size_t index = 0; index < count; index++){
+      if(alive[index] && representative[classes[index]] == -1){
+        representative[classes[index]] = (int)index;
+      }
+    }
+    std::vector<int> number(classCount, -1);
+    std::vector<int> order{classes[initial]};
+    number[classes[initial]] = 0;
+    for(std::size_t current = 0; current < order.size(); current++){
+      int index = representative[order[current]];
+      minimal.appendState((int)current, current == 0, deterministic.final_states[index]);
+      for(auto const &transition : deterministic.transitions[index]){
+        if(alive[transition.to]){
+          int classe = classes[transition.to];
+          if(number[classe] == -1){
+            number[classe] = (int)order.size();
+            order.push_back(classe);
+          }
+          minimal.transitions[current].push_back(Transition{transition.symbol, number[classe]});
+          minimal.transition_count++;
+        }
+      }
+    }
+    return minimal;
+  }
+
+  // ------------------- 21 UTF-8
+  namespace {
+    /**
+     * @brief Check the bytes one sequence at a time
+     * (Used for isValidUtf8())
+     */
+    bool isValidUtf8Scalar(const unsigned char* bytes, std::size_t size){
+      std::size_t i = 0;
+      while(i < size){
+        unsigned char lead = bytes[i];
+        if(lead < 0x80){
+          i++;
+          continue;
+        }
+        std::size_t length;
+        char32_t codePoint;
+        char32_t smallest;
+        if((lead & 0xE0) == 0xC0){
+          length = 2;
+          codePoint = lead & 0x1F;
+          smallest = 0x80;
+        }else if((lead & 0xF0) == 0xE0){
+          length = 3;
+          codePoint = lead & 0x0F;
+          smallest = 0x800;
+        }else if((lead & 0xF8) == 0xF0){
+          length = 4;
+          codePoint = lead & 0x07;
+          smallest = 0x10000;
+        }else{
+          return false;
+        }
+        if(size - i < length){
+          return false;
+        }
+        for(std::size_t k = 1; k < length; k++){
+          if((bytes[i + k] & 0xC0) != 0x80){
+            return false;
+          }
+          codePoint = codePoint << 6 | (bytes[i + k] & 0x3F);
+        }
+        if(codePoint < smallest || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF)){
+          return false;
+        }
+        i += length;
+      }
+      return true;
+    }
+
+#ifdef AUTOMATON_X86_KERNELS
+    /**
+     * @brief Check 32 bytes at a time, with the lookup algorithm of Keiser and Lemire
+     * (Used for isValidUtf8())
+     * Three tables, indexed by the nibbles of each byte and of the previous one, give the errors that the pair of bytes
+     * may be part of, and an error is found when the three agree. The bytes that must be the second or the third
+     * continuation byte of a sequence are checked with the bytes two and three positions before.
+     * The last block is padded with zeros, so that a truncated sequence at the end is an error too.
+     */
+    __attribute__((target("avx2")))
+    bool isValidUtf8Avx2(const unsigned char* bytes, std::size_t size){
+      constexpr std::uint8_t TooShort = 1 << 0; // 11______ 0_______ or 11______ 11______
+      constexpr std::uint8_t TooLong = 1 << 1; // 0_______ 10______
+      constexpr std::uint8_t Overlong3 = 1 << 2; // 11100000 100_____
+      constexpr std::uint8_t TooLarge = 1 << 3; // 11110100 1001____, 11110100 101_____, 11110101 ________ and above
+      constexpr std::uint8_t Surrogate = 1 << 4; // 11101101 101_____
+      constexpr std::uint8_t Overlong2 = 1 << 5; // 1100000_ 10______
+      constexpr std::uint8_t TooLarge1000 = 1 << 6; // 11110101 1000____ and above
+      constexpr std::uint8_t Overlong4 = 1 << 6; // 11110000 1000____
+      constexpr std::uint8_t TwoConts = 1 << 7; // 10______ 10______
+      constexpr std::uint8_t Carry = TooShort | TooLong | TwoConts;
+
+      const __m256i firstHigh = _mm256_setr_epi8(
+        TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong,
+        TwoConts, TwoConts, TwoConts, TwoConts,
+        TooShort | Overlong2, TooShort, TooShort | Overlong3 | Surrogate, TooShort | TooLarge | TooLarge1000 | Overlong4,
+        TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong,
+        TwoConts, TwoConts, TwoConts, TwoConts,
+        TooShort | Overlong2, TooShort, TooShort | Overlong3 | Surrogate, TooShort | TooLarge | TooLarge1000 | Overlong4);
+      const __m256i firstLow = _mm256_setr_epi8(
+        Carry | Overlong3 | Overlong2 | Overlong4, Carry | Overlong2, Carry, Carry,
+        Carry | TooLarge, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000 | Surrogate, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000,
+        Carry | Overlong3 | Overlong2 | Overlong4, Carry | Overlong2, Carry, Carry,
+        Carry | TooLarge, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000 | Surrogate, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000);
+      const __m256i secondHigh = _mm256_setr_epi8(
+        TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort,
+        (char)(TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge1000 | Overlong4),
+        (char)(TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge),
+        (char)(TooLong | Overlong2 | TwoConts | Surrogate | TooLarge),
+        (char)(TooLong | Overlong2 | TwoConts | Surrogate | TooLarge),
+        TooShort, TooShort, TooShort, TooShort,
+        TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort,
+        (char)(TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge1000 | Overlong4),
+        (char)(TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge),
+        (char)(TooLong | Overlong2 | TwoConts | Surrogate | TooLarge),
+        (char)(TooLong | Overlong2 | TwoConts | Surrogate | TooLarge),
+        TooShort, TooShort, TooShort, TooShort);
+      const __m256i nibble = _mm256_set1_epi8(0x0F);
+      const __m256i thirdByte = _mm256_set1_epi8((char)(0xE0 - 0x80));
+      const __m256i fourthByte = _mm256_set1_epi8((char)(0xF0 - 0x80));
+      const __m256i highBit = _mm256_set1_epi8((char)0x80);
+
+      alignas(32) unsigned char last[32] = {};
+      std::size_t blocks = size / 32;
+      std::memcpy(last, bytes + blocks * 32, size - blocks * 32);
+      __m256i previous = _mm256_setzero_si256();
+      __m256i error = _mm256_setzero_si256();
+      for(std::size_t block = 0; block <= blocks; block++){
+        __m256i input = block < blocks ? _mm256_loadu_si256((const __m256i*)(bytes + block * 32)) : _mm256_load_si256((const __m256i*)last);
+        // The bytes 1, 2 and 3 positions before each byte, taken across the previous block
+        __m256i shifted = _mm256_permute2x128_si256(previous, input, 0x21);
+        __m256i previous1 = _mm256_alignr_epi8(input, shifted, 15);
+        __m256i previous2 = _mm256_alignr_epi8(input, shifted, 14);
+        __m256i previous3 = _mm256_alignr_epi8(input, shifted, 13);
+        __m256i cases = _mm256_and_si256(
+          _mm256_and_si256(
+            _mm256_shuffle_epi8(firstHigh, _mm256_and_si256(_mm256_srli_epi16(previous1, 4), nibble)),
+            _mm256_shuffle_epi8(firstLow, _mm256_and_si256(previous1, nibble))),
+          _mm256_shuffle_epi8(secondHigh, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)));
+        __m256i mustBeContinuation = _mm256_and_si256(_mm256_or_si256(_mm256_subs_epu8(previous2, thirdByte), _mm256_subs_epu8(previous3, fourthByte)), highBit);
+        error = _mm256_or_si256(error, _mm256_xor_si256(mustBeContinuation, cases));
+        previous = input;
+      }
+      return _mm256_testz_si256(error, error);
+    }
+#endif
+
+    /**
+     * @brief Range of byte values, both ends included
+     * (Used for createUtf8())
+     */
+    struct ByteRange{
+      unsigned char first;
+      unsigned char last;
+    };
+
+    /**
+     * @brief Give the UTF-8 encoding of a code point
+     * (Used for createUtf8())
+     * @return the number of bytes
+     */
+    std::size_t encodeUtf8(char32_t codePoint, unsigned char* bytes){
+      if(codePoint < 0x80){
+        bytes[0] = (unsigned char)codePoint;
+        return 1;
+      }
+      if(codePoint < 0x800){
+        bytes[0] = (unsigned char)(0xC0 | codePoint >> 6);
+        bytes[1] = (unsigned char)(0x80 | (codePoint & 0x3F));
+        return 2;
+      }
+      if(codePoint < 0x10000){
+        bytes[0] = (unsigned char)(0xE0 | codePoint >> 12);
+        bytes[1] = (unsigned char)(0x80 | (codePoint >> 6 & 0x3F));
+        bytes[2] = (unsigned char)(0x80 | (codePoint & 0x3F));
+        return 3;
+      }
+      bytes[0] = (unsigned char)(0xF0 | codePoint >> 18);
+      bytes[1] = (unsigned char)(0x80 | (codePoint >> 12 & 0x3F));
+      bytes[2] = (unsigned char)(0x80 | (codePoint >> 6 & 0x3F));
+      bytes[3] = (unsigned char)(0x80 | (codePoint & 0x3F));
+      return 4;
+    }
+
+    /**
+     * @brief Split a range of code points into sequences of ranges of bytes, each sequence accepting the encodings of a part of the range
+     * (Used for createUtf8())
+     * The range is cut at the surrogates and at the changes of length of the encoding, then until all the code points
+     * of a part only differ in the bytes where the part covers every continuation byte.
+     */
+    void splitUtf8(char32_t first, char32_t last, std::vector<std::vector<ByteRange>>& sequences){
+      if(first > last){
+        return;
+      }
+      if(first <= 0xDFFF && last >= 0xD800){
+        if(first < 0xD800){
+          splitUtf8(first, 0xD7FF, sequences);
+        }
+        if(last > 0xDFFF){
+          splitUtf8(0xE000, last, sequences);
+        }
+        return;
+      }
+      for(char32_t limit : {0x7Fu, 0x7FFu, 0xFFFFu}){
+        if(first <= limit && last > limit){
+          splitUtf8(first, limit, sequences);
+          splitUtf8(limit + 1, last, sequences);
+          return;
+        }
+      }
+      unsigned char low[4];
+      unsigned char high[4];
+      std::size_t length = encodeUtf8(first, low);
+      for(std::size_t i = 1; i < length; i++){
+        char32_t mask = ((char32_t)1 << (6 * i)) - 1;
+        if((first & ~mask) != (last & ~mask)){
+          if((first & mask) != 0){
+            splitUtf8(first, first | mask, sequences);
+            splitUtf8((first | mask) + 1, last, sequences);
+            return;
+          }
+          if((last & mask) != mask){
+            splitUtf8(first, (last & ~mask) - 1, sequences);
+            splitUtf8(last & ~mask, last, sequences);
+            return;
+          }
+        }
+      }
+      encodeUtf8(last, high);
+      std::vector<ByteRange> sequence;
+      for(std::size_t i = 0; i < length; i++){
+        sequence.push_back(ByteRange{low[i], high[i]});
+      }
+      sequences.push_back(std::move(sequence));
+    }
+  }
+
+  /**
+   * @brief Tell if the bytes are valid UTF-8, with AVX2 when the processor supports it
+   *
+   * @param bytes the text to check
+   * @return true if the text is valid UTF-8
+   */
+  bool isValidUtf8(std::string_view bytes){
+    const unsigned char* data = (const unsigned char*)bytes.data();
+#ifdef AUTOMATON_X86_KERNELS
+    if(__builtin_cpu_supports("avx2")){
+      return isValidUtf8Avx2(data, bytes.size());
+    }
+#endif
+    return isValidUtf8Scalar(data, bytes.size());
+  }
+
+  /**
+   * @brief Tell if the bytes are accepted, following all the paths at once
+   *
+   * @param bytes the word, each byte being the symbol of its value
+   * @return true if the word is accepted
+   */
+  bool TokenAutomaton::matchBytes(std::string_view bytes) const{
+    assert(isValid());
+    return matchSymbols(bytes.begin(), bytes.end());
+  }
+
+  /**
+   * @brief Determinize the automaton and build its table of 256 columns, with a dead state for the missing transitions
+   *
+   * @param automaton the automaton over bytes to match
+   * @param limits the limits of the determinization
+   */
+  ByteMatcher::ByteMatcher(const TokenAutomaton& automaton, const Limits& limits)
+  : initial(0)
+  {
+    assert(automaton.isValid());
+    TokenAutomaton deterministic = TokenAutomaton::createDeterministic(automaton, limits);
+
+    std::size_t dead = deterministic.values.size();
+    std::size_t count = dead + 1;
+    if(count * 256 > (std::size_t)std::numeric_limits<std::int32_t>::max()){
+      throw LimitExceeded(LimitExceeded::Reason::States, count);
+    }
+    next.assign(count * 256, (std::int32_t)dead);
+    finals.assign(count, 0);
+    for(std::size_t state = 0; state < dead; state++){
+      for(auto const &transition : deterministic.transitions[state]){
+        if(transition.symbol <= UCHAR_MAX){
+          next[state * 256 + transition.symbol] = transition.to;
+        }
+      }
+      finals[state] = deterministic.final_states[state] ? 1 : 0;
+    }
+    std::vector<int> initials = initialIndexes(deterministic.initial_states);
+    initial = initials.empty() ? (std::int32_t)dead : initials.front();
+  }
+
+  /**
+   * @brief Tell if the bytes are accepted by the automaton, with one load of the table per byte
+   *
+   * @param bytes the text to read
+   * @return true if the automaton accepts the text
+   */
+  bool ByteMatcher::match(std::string_view bytes) const{
+    std::int32_t state = initial;
+    for(auto const byte : bytes){
+      state = next[(std::size_t)state * 256 + (unsigned char)byte];
+    }
+    return finals[state] != 0;
+  }
+
+  /**
+   * @brief Give the number of states of the table
+   *
+   * @return std::size_t the number of states, including the dead state
+   */
+  std::size_t ByteMatcher::countStates() const{
+    return finals.size();
+  }
+
+  /**
+   * @brief Compile an automaton over ranges of code points into an automaton over the bytes of their UTF-8 encoding
+   *
+   * Each range is split into sequences of ranges of bytes. A sequence is added from its end : the state that reads the
+   * last byte range before the target is looked up by its range and its target, so the sequences that end the same way
+   * share their states, and the continuation bytes cost a few states for the whole automaton.
+   * @param automaton the automaton whose symbols are indexes in ranges
+   * @param ranges the code points of each symbol
+   * @return TokenAutomaton over the 256 bytes
+   */
+  TokenAutomaton TokenAutomaton::createUtf8(const TokenAutomaton& automaton, const std::vector<CodePointRange>& ranges){
+    assert(automaton.isValid());
+
+    std::map<Symbol, std::vector<std::vector<ByteRange>>> sequences;
+    for(auto const symbol : automaton.alphabet){
+      if(symbol >= ranges.size() || ranges[symbol].first > ranges[symbol].last || ranges[symbol].last > 0x10FFFF){
+        throw std::invalid_argument("The symbol has no valid range of code points");
+      }
+      splitUtf8(ranges[symbol].first, ranges[symbol].last, sequences[symbol]);
+      // A range made of surrogates only has no encoding
+      if(sequences[symbol].empty()){
+        throw std::invalid_argument("The symbol has no valid range of code points");
+      }
+    }
+
+    TokenAutomaton bytes;
+    for(Symbol byte = 0; byte < 256; byte++){
+      bytes.alphabet.push_back(byte);
+    }
+    int number = 0;
+    for(std::size_t index = 0; index < automaton.values.size(); index++){
+      bytes.appendState(automaton.values[index], automaton.initial_states[index], automaton.final_states[index]);
+      number = std::max(number, automaton.values[index] + 1);
+    }
+
+    std::map<std::tuple<unsigned char, unsigned char, int>, int> suffixes;
+    auto addRange = [&](int from, ByteRange range, int to){
+      for(unsigned byte = range.first; byte <= range.last; byte++){
+        bytes.transitions[from].push_back(Transition{byte, to});
+      }
+    };
+    for(std::size_t index = 0; index < automaton.values.size(); index++){
+      for(auto const &transition : automaton.transitions[index]){
+        for(auto const &sequence : sequences[transition.symbol]){
+          int current = transition.to;
+          for(std::size_t i = sequence.size() - 1; i > 0; i--){
+            auto inserted = suffixes.insert({std::make_tuple(sequence[i].first, sequence[i].last, current), (int)bytes.values.size()});
+            if(inserted.second){
+              bytes.appendState(number++, false, false);
+              addRange(inserted.first->second, sequence[i], current);
+            }
+            current = inserted.first->second;
+          }
+          addRange((int)index, sequence[0], current);
+        }
+      }
+    }
+
+    for(auto &outgoing : bytes.transitions){
+      std::sort(outgoing.begin(), outgoing.end(), isTransitionBefore<Transition>);
+      outgoing.erase(std::unique(outgoing.begin(), outgoing.end(), [](const Transition& lhs, const Transition& rhs){
+        return lhs.symbol == rhs.symbol && lhs.to == rhs.to;
+      }), outgoing.end());
+      bytes.transition_count += outgoing.size();
+    }
+    return bytes;
+  }
+
+  // ------------------- 22 Automate symbolique
+  /**
+   * @brief Build an empty set
+   */
+  SymbolSet::SymbolSet()
+  {
+  }
+
+  /**
+   * @brief Build the set of the symbols from first to last
+   */
+  SymbolSet SymbolSet::range(Symbol first, Symbol last){
+    SymbolSet set;
+    if(first <= last){
+      set.intervals.push_back(Interval{first, last});
+    }
+    return set;
+  }
+
+  /**
+   * @brief Build the set of one symbol
+   */
+  SymbolSet SymbolSet::single(Symbol symbol){
+    return range(symbol, symbol);
+  }
+
+  /**
+   * @brief Build the set of all the symbols
+   */
+  SymbolSet SymbolSet::all(){
+    return range(0, std::numeric_limits<Symbol>::max());
+  }
+
+  /**
+   * @brief Build a set from intervals, sorting them and merging the ones that overlap or touch
+   *
+   * @param intervals the intervals, the ones whose last symbol is before the first being ignored
+   * @return SymbolSet the union of the intervals
+   */
+  SymbolSet SymbolSet::fromIntervals(std::vector<Interval> intervals){
+    intervals.erase(std::remove_if(intervals.begin(), intervals.end(), [](const Interval& interval){
+      return interval.first > interval.last;
+    }), intervals.end());
+    std::sort(intervals.begin(), intervals.end(), [](const Interval& lhs, const Interval& rhs){
+      return lhs.first < rhs.first;
+    });
+    SymbolSet set;
+    for(auto const &interval : intervals){
+      if(!set.intervals.empty() && (std::uint64_t)interval.first <= (std::uint64_t)set.intervals.back().last + 1){
+        set.intervals.back().last = std::max(set.intervals.back().last, interval.last);
+      }else{
+        set.intervals.push_back(interval);
+      }
+    }
+    return set;
+  }
+
+  bool SymbolSet::isEmpty() const{
+    return intervals.empty();
+  }
+
+  /**
+   * @brief Tell if the symbol is in the set, with a binary search of its interval
+   */
+  bool SymbolSet::contains(Symbol symbol) const{
+    auto after = std::upper_bound(intervals.begin(), intervals.end(), symbol, [](Symbol value, const Interval& interval){
+      return value < interval.first;
+    });
+    return after != intervals.begin() && std::prev(after)->last >= symbol;
+  }
+
+  std::uint64_t SymbolSet::countSymbols() const{
+    std::uint64_t count = 0;
+    for(auto const &interval : intervals){
+      count += (std::uint64_t)interval.last - interval.first + 1;
+    }
+    return count;
+  }
+
+  SymbolSet SymbolSet::unionWith(const SymbolSet& other) const{
+    std::vector<Interval> both = intervals;
+    both.insert(both.end(), other.intervals.begin(), other.intervals.end());
+    return fromIntervals(std::move(both));
+  }
+
+  /**
+   * @brief Intersect two sets, walking their sorted intervals side by side
+   */
+  SymbolSet SymbolSet::intersectionWith(const SymbolSet& other) const{
+    SymbolSet set;
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while(i < intervals.size() && j < other.intervals.size()){
+      Symbol first = std::max(intervals[i].first, other.intervals[j].first);
+      Symbol last = std::min(intervals[i].last, other.intervals[j].last);
+      if(first <= last){
+        set.intervals.push_back(Interval{first, last});
+      }
+      if(intervals[i].last < other.intervals[j].last){
+        i++;
+      }else{
+        j++;
+      }
+    }
+    return set;
+  }
+
+  /**
+   * @brief Give the set of the symbols between the intervals
+   */
+  SymbolSet SymbolSet::complement() const{
+    SymbolSet set;
+    std::uint64_t next = 0;
+    for(auto const &interval : intervals){
+      if(next < interval.first){
+        set.intervals.push_back(Interval{(Symbol)next, interval.first - 1});
+      }
+      next = (std::uint64_t)interval.last + 1;
+    }
+    if(next <= std::numeric_limits<Symbol>::max()){
+      set.intervals.push_back(Interval{(Symbol)next, std::numeric_limits<Symbol>::max()});
+    }
+    return set;
+  }
+
+  const std::vector<SymbolSet::Interval>& SymbolSet::getIntervals() const{
+    return intervals;
+  }
+
+  bool SymbolSet::operator==(const SymbolSet& other) const{
+    return intervals.size() == other.intervals.size() && std::equal(intervals.begin(), intervals.end(), other.intervals.begin(), [](const Interval& lhs, const Interval& rhs){
+      return lhs.first == rhs.first && lhs.last == rhs.last;
+    });
+  }
+
+  bool SymbolSet::operator!=(const SymbolSet& other) const{
+    return !(*this == other);
+  }
+
+  namespace {
+    /**
+     * @brief Cut the symbols covered by labelled sets into segments where the same labels are present, and give each segment with its sorted labels
+     * (Used for SymbolicAutomaton::createDeterministic() and SymbolicAutomaton::createMinimal())
+     * The ends of the intervals are swept in order, counting how many intervals of each label cover the current symbol.
+     * @param sets the sets with their labels, a label being allowed on several sets
+     * @param callback called with each segment covered by at least one set, in increasing order
+     */
+    void forEachSegment(const std::vector<std::pair<const SymbolSet*, int>>& sets, const std::function<void(const SymbolSet::Interval&, const std::vector<int>&)>& callback){
+      struct Event{
+        std::uint64_t position;
+        int label;
+        int change;
+      };
+      std::vector<Event> events;
+      for(auto const &set : sets){
+        for(auto const &interval : set.first->getIntervals()){
+          events.push_back(Event{interval.first, set.second, 1});
+          events.push_back(Event{(std::uint64_t)interval.last + 1, set.second, -1});
+        }
+      }
+      std::sort(events.begin(), events.end(), [](const Event& lhs, const Event& rhs){
+        return lhs.position < rhs.position;
+      });
+      std::map<int, int> active;
+      std::vector<int> labels;
+      for(std::size_t i = 0; i < events.size(); ){
+        std::uint64_t position = events[i].position;
+        for(; i < events.size() && events[i].position == position; i++){
+          int &count = active[events[i].label];
+          count += events[i].change;
+          if(count == 0){
+            active.erase(events[i].label);
+          }
+        }
+        if(!active.empty() && i < events.size()){
+          labels.clear();
+          for(auto const &label : active){
+            labels.push_back(label.first);
+          }
+          callback(SymbolSet::Interval{(SymbolSet::Symbol)position, (SymbolSet::Symbol)(events[i].position - 1)}, labels);
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Build an empty automaton
+   */
+  SymbolicAutomaton::SymbolicAutomaton()
+  {
+  }
+
+  /**
+   * @brief Build the symbolic automaton equivalent to an automaton over characters
+   *
+   * @param automaton an automaton without epsilon-transition
+   * @return SymbolicAutomaton with the same states, the letters from a state to another being grouped on one transition
+   */
+  SymbolicAutomaton SymbolicAutomaton::fromAutomaton(const Automaton& automaton){
+    assert(!automaton.hasEpsilonTransition());
+
+    SymbolicAutomaton symbolic;
+    for(std::size_t index = 0; index < automaton.values.size(); index++){
+      symbolic.appendState(automaton.values[index], automaton.initial_states.test(index), automaton.final_states.test(index));
+    }
+    for(std::size_t index = 0; index < automaton.values.size(); index++){
+      for(auto const &transition : automaton.transitions[index]){
+        symbolic.appendTransition((int)index, SymbolSet::single((unsigned char)transition.alpha), transition.to);
+      }
+    }
+    return symbolic;
+  }
+
+  /**
+   * @brief Tell if the current automaton has at least one state
+   */
+  bool SymbolicAutomaton::isValid() const{
+    return !values.empty();
+  }
+
+  /**
+   * @brief Private function that gives the dense index of a state
+   * (Used for all the functions taking the number of a state)
+   */
+  int SymbolicAutomaton::indexOf(int state) const{
+    return denseIndexOf(indexes, state);
+  }
+
+  /**
+   * @brief Private function that adds a state without checking it, and gives its dense index
+   * (Used for addState() and the transformations)
+   */
+  int SymbolicAutomaton::appendState(int state, bool isInitial, bool isFinal){
+    return appendDenseState(values, indexes, initial_states, final_states, transitions, state, isInitial, isFinal);
+  }
+
+  /**
+   * @brief Private function that adds symbols to the transition between two dense indexes, creating it if needed
+   * (Used for addTransition() and the transformations)
+   */
+  void SymbolicAutomaton::appendTransition(int from, const SymbolSet& symbols, int to){
+    auto &outgoing = transitions[from];
+    auto position = std::lower_bound(outgoing.begin(), outgoing.end(), to, [](const Transition& transition, int target){
+      return transition.to < target;
+    });
+    if(position != outgoing.end() && position->to == to){
+      position->symbols = position->symbols.unionWith(symbols);
+    }else{
+      outgoing.insert(position, Transition{symbols, to});
+    }
+  }
+
+  bool SymbolicAutomaton::addState(int state){
+    if(state < 0 || hasState(state)){
+      return false;
+    }
+    appendState(state, false, false);
+    return true;
+  }
+
+  bool SymbolicAutomaton::hasState(int state) const{
+    return state >= 0 && indexOf(state) != -1;
+  }
+
+  std::size_t SymbolicAutomaton::countStates() const{
+    return values.size();
+  }
+
+  void SymbolicAutomaton::setStateInitial(int state){
+    int index = indexOf(state);
+    if(index != -1){
+      initial_states[index] = true;
+    }
+  }
+
+  bool SymbolicAutomaton::isStateInitial(int state) const{
+    int index = indexOf(state);
+    return index != -1 && initial_states[index];
+  }
+
+  void SymbolicAutomaton::setStateFinal(int state){
+    int index = indexOf(state);
+    if(index != -1){
+      final_states[index] = true;
+    }
+  }
+
+  bool SymbolicAutomaton::isStateFinal(int state) const{
+    int index = indexOf(state);
+    return index != -1 && final_states[index];
+  }
+
+  /**
+   * @brief Add the symbols to the transition from a state to another
+   *
+   * @param from the origin of the transition
+   * @param symbols the symbols to add
+   * @param to the target of the transition
+   * @return true if the symbols have been added
+   * @return false if a state is missing or if there is no symbol
+   */
+  bool SymbolicAutomaton::addTransition(int from, const SymbolSet& symbols, int to){
+    int fromIndex = indexOf(from);
+    int toIndex = indexOf(to);
+    if(fromIndex == -1 || toIndex == -1 || symbols.isEmpty()){
+      return false;
+    }
+    appendTransition(fromIndex, symbols, toIndex);
+    return true;
+  }
+
+  /**
+   * @brief Give the symbols of the transition from a state to another
+   */
+  SymbolSet SymbolicAutomaton::getTransition(int from, int to) const{
+    int fromIndex = indexOf(from);
+    int toIndex = indexOf(to);
+    if(fromIndex != -1 && toIndex != -1){
+      for(auto const &transition : transitions[fromIndex]){
+        if(transition.to == toIndex){
+          return transition.symbols;
+        }
+      }
+    }
+    return SymbolSet();
+  }
+
+  std::size_t SymbolicAutomaton::countTransitions() const{
+    std::size_t count = 0;
+    for(auto const &outgoing : transitions){
+      count += outgoing.size();
+    }
+    return count;
+  }
+
+  /**
+   * @brief Tell if there is one initial state and if the sets of the transitions of each state are disjoint
+   */
+  bool SymbolicAutomaton::isDeterministic() const{
+    assert(isValid());
+    if(std::count(initial_states.begin(), initial_states.end(), true) != 1){
+      return false;
+    }
+    std::vector<SymbolSet::Interval> intervals;
+    for(auto const &outgoing : transitions){
+      intervals.clear();
+      for(auto const &transition : outgoing){
+        intervals.insert(intervals.end(), transition.symbols.getIntervals().begin(), transition.symbols.getIntervals().end());
+      }
+      std::sort(intervals.begin(), intervals.end(), [](const SymbolSet::Interval& lhs, const SymbolSet::Interval& rhs){
+        return lhs.first < rhs.first;
+      });
+      for(std::size_t i = 1; i < intervals.size(); i++){
+        if(intervals[i].first <= intervals[i - 1].last){
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Tell if the transitions of each state cover all the symbols
+   */
+  bool SymbolicAutomaton::isComplete() const{
+    assert(isValid());
+    for(auto const &outgoing : transitions){
+      SymbolSet covered;
+      for(auto const &transition : outgoing){
+        covered = covered.unionWith(transition.symbols);
+      }
+      if(covered != SymbolSet::all()){
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Tell if no final state can be reached from an initial state
+   */
+  bool SymbolicAutomaton::isLanguageEmpty() const{
+    assert(isValid());
+    return isLanguageEmptyOf(initial_states, final_states, transitions);
+  }
+
+  /**
+   * @brief Tell if the word is accepted, following all the paths at once
+   */
+  bool SymbolicAutomaton::match(const std::vector<Symbol>& word) const{
+    assert(isValid());
+    std::vector<int> current;
+    for(std::size_t index = 0; index < values.size(); index++){
+      if(initial_states[index]){
+        current.push_back((int)index);
+      }
+    }
+    std::vector<int> next;
+    for(auto const symbol : word){
+      next.clear();
+      for(auto const index : current){
+        for(auto const &transition : transitions[index]){
+          if(transition.symbols.contains(symbol)){
+            next.push_back(transition.to);
+          }
+        }
+      }
+      std::sort(next.begin(), next.end());
+      next.erase(std::unique(next.begin(), next.end()), next.end());
+      current.swap(next);
+      if(current.empty()){
+        return false;
+      }
+    }
+    for(auto const index : current){
+      if(final_states[index]){
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Create a complete automaton, with a sink state that receives the missing symbols of each state
+   *
+   * @param other the automaton to complete
+   * @return SymbolicAutomaton other itself if it is already complete
+   */
+  SymbolicAutomaton SymbolicAutomaton::createComplete(const SymbolicAutomaton& other){
+    assert(other.isValid());
+    if(other.isComplete()){
+      return other;
+    }
+    SymbolicAutomaton complete = other;
+    int sink = complete.appendState(freeStateOf(complete.values), false, false);
+    for(int index = 0; index < sink; index++){
+      SymbolSet covered;
+      for(auto const &transition : complete.transitions[index]){
+        covered = covered.unionWith(transition.symbols);
+      }
+      SymbolSet missing = covered.complement();
+      if(!missing.isEmpty()){
+        complete.appendTransition(index, missing, sink);
+      }
+    }
+    complete.appendTransition(sink, SymbolSet::all(), sink);
+    return complete;
+  }
+
+  /**
+   * @brief Create a deterministic automaton with the subset construction, on the minterms of each subset
+   *
+   * The sets of the transitions leaving a subset are cut into segments where the same targets are reached, and the
+   * segments leading to the same targets are grouped on one transition.
+   * @param other the automaton to determinize
+   * @param limits the limits of the determinization
+   * @return a deterministic automaton, other itself if it is already deterministic
+   */
+  SymbolicAutomaton SymbolicAutomaton::createDeterministic(const SymbolicAutomaton& other, const Limits& limits){
+    assert(other.isValid());
+
+    Measure measure;
+    if(other.isDeterministic()){
+      return other;
+    }
+
+    Budget budget(limits);
+    SymbolicAutomaton deterministic;
+    SubsetNumbers numbers;
+    auto addState = [&](int nb, bool isFinal){
+      deterministic.appendState(nb, nb == 0, isFinal);
+    };
+    numbers.add(initialIndexes(other.initial_states), other.final_states, budget, addState);
+
+    std::vector<std::pair<const SymbolSet*, int>> sets;
+    std::vector<std::vector<int>> targets;
+    std::vector<std::vector<SymbolSet::Interval>> segments;
+    std::unordered_map<std::vector<int>, std::size_t, SubsetHash> groups;
+    for(std::size_t current = 0; current < numbers.subsets.size(); current++){
+      sets.clear();
+      for(auto const index : numbers.subsets[current]){
+        for(auto const &transition : other.transitions[index]){
+          sets.push_back({&transition.symbols, transition.to});
+        }
+      }
+      targets.clear();
+      segments.clear();
+      groups.clear();
+      forEachSegment(sets, [&](const SymbolSet::Interval& segment, const std::vector<int>& to){
+        auto inserted = groups.insert({to, targets.size()});
+        if(inserted.second){
+          targets.push_back(to);
+          segments.emplace_back();
+        }
+        segments[inserted.first->second].push_back(segment);
+      });
+      for(std::size_t group = 0; group < targets.size(); group++){
+        budget.addTransition();
+        int to = numbers.find(targets[group]);
+        if(to == -1){
+          to = numbers.add(std::vector<int>(targets[group]), other.final_states, budget, addState);
+        }
+        deterministic.appendTransition((int)current, SymbolSet::fromIntervals(std::move(segments[group])), to);
+      }
+    }
+    if(measure.get() != nullptr){
+      measure.get()->subsetsCreated += numbers.subsets.size();
+    }
+    return deterministic;
+  }
+
+  /**
+   * @brief Create the synchronized product of two automata, the sets of the transitions being intersected
+   *
+   * @param lhs the left hand automaton
+   * @param rhs the right hand automaton
+   * @param limits the limits of the product
+   * @return SymbolicAutomaton whose states are the reachable pairs of states, numbered in breadth-first order
+   */
+  SymbolicAutomaton SymbolicAutomaton::createProduct(const SymbolicAutomaton& lhs, const SymbolicAutomaton& rhs, const Limits& limits){
+    assert(lhs.isValid());
+    assert(rhs.isValid());
+
+    Measure measure;
+    Budget budget(limits);
+    SymbolicAutomaton product;
+    PairNumbers numbers;
+    auto addState = [&](int nb, int left, int right){
+      product.appendState(nb, false, lhs.final_states[left] && rhs.final_states[right]);
+    };
+    auto addPair = [&](int left, int right){
+      return numbers.numberOf(left, right, budget, addState);
+    };
+    for(auto const nb : numbers.addInitials(lhs.initial_states, rhs.initial_states, budget, addState)){
+      product.initial_states[nb] = true;
+    }
+
+    auto const &pairs = numbers.pairs;
+    for(std::size_t current = 0; current < pairs.size(); current++){
+      for(auto const &left : lhs.transitions[pairs[current].first]){
+        for(auto const &right : rhs.transitions[pairs[current].second]){
+          SymbolSet symbols = left.symbols.intersectionWith(right.symbols);
+          if(!symbols.isEmpty()){
+            budget.addTransition();
+            product.appendTransition((int)current, symbols, addPair(left.to, right.to));
+          }
+        }
+      }
+    }
+    if(measure.get() != nullptr){
+      measure.get()->productPairs += pairs.size();
+    }
+    if(product.values.empty()){
+      product.appendState(0, true, false);
+    }
+    return product;
+  }
+
+  /**
+   * @brief Create the minimal deterministic automaton with the algorithm of Moore, on the transitions of each state
+   *
+   * The useless states are removed first, so a missing transition leads to the implicit dead state. At each round,
+   * the signature of a state is its class and, for each class it reaches, the symbols leading there. The cost of a
+   * round follows the number of intervals on the transitions, not the number of minterms of the whole automaton.
+   * @param other the automaton to minimize
+   * @param limits the limits of the determinization and of the refinement rounds
+   * @return SymbolicAutomaton the minimal automaton, with one non final state if the language is empty
+   */
+  SymbolicAutomaton SymbolicAutomaton::createMinimal(const SymbolicAutomaton& other, const Limits& limits){
+    assert(other.isValid());
+
+    Measure measure;
+    SymbolicAutomaton deterministic = createDeterministic(other, limits);
+    Budget budget(limits);
+    std::size_t count = deterministic.values.size();
+    int initial = (int)(std::find(deterministic.initial_states.begin(), deterministic.initial_states.end(), true) - deterministic.initial_states.begin());
+
+    std::vector<bool> alive = usefulStates(initial, deterministic.final_states, deterministic.transitions);
+
+    SymbolicAutomaton minimal;
+    if(!alive[initial]){
+      minimal.appendState(0, true, false);
+      return minimal;
+    }
+
+    // Congruence 0 : the non final states in class 0 and the final ones in class 1
+    std::vector<int> classes(count, -1);
+    for(std::size_t index = 0; index < count; index++){
+      if(alive[index]){
+        classes[index] = deterministic.final_states[index] ? 1 : 0;
+      }
+    }
+    std::size_t classCount = 0;
+
+    // The automaton is deterministic, so the sets of the transitions of a state are disjoint, and two states of the same
+    // class stay together if they send the same symbols to each class : the sets going to the same class are merged
+    auto symbolsByClass = [&](int index, std::map<int, SymbolSet>& symbolsTo){
+      symbolsTo.clear();
+      for(auto const &transition : deterministic.transitions[index]){
+        if(alive[transition.to]){
+          SymbolSet &symbols = symbolsTo[classes[transition.to]];
+          symbols = symbols.unionWith(transition.symbols);
+        }
+      }
+    };
+
+    std::map<int, SymbolSet> symbolsTo;
+    std::vector<std::int64_t> signature;
+    for(bool isFirstRound = true; ; isFirstRound = false){
+      budget.poll();
+      if(measure.get() != nullptr){
+        measure.get()->refinementRounds++;
+      }
+
+      // The signature of a state is its class, then each class it goes to with its intervals
+      std::map<std::vector<std::int64_t>, int> numbers;
+      std::vector<int> refined(count, -1);
+      for(std::size_t index = 0; index < count; index++){
+        if(!alive[index]){
+          continue;
+        }
+        symbolsByClass((int)index, symbolsTo);
+        signature.assign(1, classes[index]);
+        for(auto const &symbols : symbolsTo){
+          signature.push_back(symbols.first);
+          signature.push_back((std::int64_t)symbols.second.getIntervals().size());
+          for(auto const &interval : symbols.second.getIntervals()){
+            signature.push_back(interval.first);
+            signature.push_back(interval.last);
+          }
+        }
+        auto inserted = numbers.insert({signature, (int)numbers.size()});
+        // The signatures have about the same size at each round, so they are only charged once
+        if(isFirstRound && inserted.second){
+          budget.addBytes(sizeof(std::vector<std::int64_t>) + NodeOverhead + signature.size() * sizeof(std::int64_t));
+        }
+        refined[index] = inserted.first->second;
+      }
+      classes.swap(refined);
+      if(numbers.size() == classCount){
+        break;
+      }
+      classCount = numbers.size();
+    }
+
+    // One state per class, numbered in breadth-first order from the class of the initial state
+    std::vector<int> representative(classCount, -1);
+    for(std::size_t index = 0; index < count; index++){
+      if(alive[index] && representative[classes[index]] == -1){
+        representative[classes[index]] = (int)index;
+      }
+    }
+    std::vector<int> number(classCount, -1);
+    std::vector<int> order{classes[initial]};
+    number[classes[initial]] = 0;
+    for(std::size_t current = 0; current < order.size(); current++){
+      int index = representative[order[current]];
+      minimal.appendState((int)current, current == 0, deterministic.final_states[index]);
+      symbolsByClass(index, symbolsTo);
+      // The new classes are numbered in the order of their first symbol
+      std::vector<std::pair<SymbolSet, int>> targets;
+      for(auto &symbols : symbolsTo){
+        targets.push_back({std::move(symbols.second), symbols.first});
+      }
+      std::sort(targets.begin(), targets.end(), [](const std::pair<SymbolSet, int>& lhs, const std::pair<SymbolSet, int>& rhs){
+        return lhs.first.getIntervals().front().first < rhs.first.getIntervals().front().first;
+      });
+      for(auto const &target : targets){
+        if(number[target.second] == -1){
+          number[target.second] = (int)order.size();
+          order.push_back(target.second);
+        }
+        minimal.appendTransition((int)current, target.first, number[target.second]);
+      }
+    }
+    return minimal;
+  }
+
+  // ------------------- 23 Instantane immuable
+  /**
+   * @brief Build the snapshot of an empty automaton
+   */
+  AutomatonSnapshot::AutomatonSnapshot()
+  : automaton(std::make_shared<Automaton>())
+  {
+  }
+
+  /**
+   * @brief Take a snapshot of an automaton, compacting its storage
+   *
+   * @param automaton the automaton, copied by the caller or moved in
+   */
+  AutomatonSnapshot::AutomatonSnapshot(Automaton automaton)
+  : automaton(std::make_shared<Automaton>(std::move(automaton)))
+  {
+    this->automaton->shrinkToFit();
+  }
+
+  const Automaton& AutomatonSnapshot::get() const{
+    return *automaton;
+  }
+
+  const Automaton& AutomatonSnapshot::operator*() const{
+    return *automaton;
+  }
+
+  const Automaton* AutomatonSnapshot::operator->() const{
+    return automaton.get();
+  }
+
+  /**
+   * @brief Give a mutable copy of the automaton of the snapshot
+   */
+  Automaton AutomatonSnapshot::toAutomaton() const &{
+    return *automaton;
+  }
+
+  /**
+   * @brief Give a mutable automaton, moving the storage out if this snapshot is its only owner
+   *
+   * If the count of owners is 1, no other snapshot can be copying this one at the same time, since it would have to
+   * be an owner too, so the storage can be taken.
+   * @return Automaton the automaton of the snapshot
+   */
+  Automaton AutomatonSnapshot::toAutomaton() &&{
+    std::shared_ptr<Automaton> taken = std::make_shared<Automaton>();
+    taken.swap(automaton);
+    if(taken.use_count() == 1){
+      return std::move(*taken);
+    }
+    return *taken;
+  }
+
+  std::size_t AutomatonSnapshot::countShares() const{
+    return (std::size_t)automaton.use_count();
+  }
+}
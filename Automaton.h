@@ -1,33 +1,187 @@
 #ifndef AUTOMATON_H
 #define AUTOMATON_H
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iosfwd>
 #include <set>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <iostream>
 #include <vector>
 #include <iterator>
+#include <list>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <random>
 #include <unordered_map>
 #include <bits/stdc++.h> 
 
-struct State{
-  int value;
-  bool isInitial;
-  bool isFinal;
-};
-
-struct Arc{
-  int from;
-  char alpha;
-  int to; 
-};
-
 namespace fa {
 
   constexpr char Epsilon = '\0';
 
+  /**
+   * Limits of the resources a transformation may use.
+   *
+   * A zero maximum means no limit. The deadline, the cancellation flag and the
+   * progress callback are checked every few hundred created states. The progress
+   * callback is called by the worker threads of the parallel transformations.
+   */
+  struct Limits {
+    std::size_t maxStates = 0;
+    std::size_t maxBytes = 0; // Approximation of the memory of the created states and transitions
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    const std::atomic<bool>* cancelled = nullptr;
+    std::function<void(std::size_t states)> progress;
+  };
+
+  /**
+   * Counters of the costly operations, filled while a StatisticsScope is alive on the thread.
+   *
+   * The counters are added from one operation to the next. The wall time
+   * and the number of operations only count the outermost operations, so a
+   * determinization done inside createMinimalMoore() isn't counted twice.
+   */
+  struct Statistics {
+    std::size_t operations = 0; // createDeterministic(), createProduct(), createMinimal...(), isIncludedIn(), isEquivalentTo() and hasEmptyIntersectionWith()
+    std::size_t statesExplored = 0; // States created by the transformations, before any trimming
+    std::size_t transitionsExplored = 0;
+    std::size_t subsetsCreated = 0; // Sets of states met by the determinizations
+    std::size_t productPairs = 0; // Tuples of states met by the products, and pairs of sets of states met by isEquivalentTo()
+    std::size_t refinementRounds = 0; // Rounds of createMinimalMoore() and createMinimalMooreParallel()
+    std::size_t peakBytes = 0; // Largest approximation of the memory of the states and transitions created by one transformation
+    std::chrono::nanoseconds wallTime = std::chrono::nanoseconds::zero();
+  };
+
+  /**
+   * Collect the statistics of the operations done by the current thread, as long as the scope is alive.
+   *
+   * Without a scope, the operations only check a thread-local pointer. The
+   * parallel operations count the work of their threads in the statistics
+   * of the thread that called them. Nested scopes hide the outer ones.
+   */
+  class StatisticsScope {
+  public:
+    explicit StatisticsScope(Statistics& statistics);
+    ~StatisticsScope();
+
+    StatisticsScope(const StatisticsScope&) = delete;
+    StatisticsScope& operator=(const StatisticsScope&) = delete;
+
+  private:
+    Statistics* previous;
+  };
+
+  /**
+   * Memory used by an automaton, in bytes, by part
+   *
+   * The sizes count the capacity of the containers, the nodes of the node
+   * based containers and an estimate of the overhead of each allocation.
+   */
+  struct MemoryUsage {
+    std::size_t states = 0; // The object itself, the numbers of the states, their flags and their vectors of transitions
+    std::size_t arcs = 0; // The transitions
+    std::size_t alphabet = 0;
+    std::size_t indexes = 0; // The hash table from the numbers of the states to their positions
+    std::size_t caches = 0; // Data derived from the rest to speed up the operations, like the sorted list of the initial states
+
+    std::size_t total() const {
+      return states + arcs + alphabet + indexes + caches;
+    }
+  };
+
+  /**
+   * Options of prettyPrint() and dotPrint()
+   */
+  struct PrintOptions {
+    bool mergeParallelEdges = true; // dotPrint() draws one edge per pair of states, labelled with all its letters
+    std::size_t maxBytes = 0; // The output stops after about this many bytes, with a truncation mark ; zero means no limit
+  };
+
+  /**
+   * Options of emitCpp()
+   */
+  struct EmitOptions {
+    enum class Style {
+      Switch, // One case per state, and one case per letter : the fastest for small automata
+      Tables, // constexpr tables of the transitions, indexed by state and by letter
+    };
+
+    Style style = Style::Switch;
+    std::string functionName = "match"; // Name of the generated function, also used as a prefix for the tables
+    std::string namespaceName; // Namespace of the generated code, none if empty
+  };
+
+  /**
+   * Hash of 128 bits
+   */
+  struct Hash128 {
+    std::uint64_t low;
+    std::uint64_t high;
+  };
+
+  bool operator==(const Hash128& lhs, const Hash128& rhs);
+  bool operator!=(const Hash128& lhs, const Hash128& rhs);
+  bool operator<(const Hash128& lhs, const Hash128& rhs);
+
+  /**
+   * Error thrown when a transformation goes beyond its limits
+   */
+  class LimitExceeded : public std::runtime_error {
+
+  public:
+    enum class Reason { States, Bytes, Deadline, Cancelled };
+
+    LimitExceeded(Reason reason, std::size_t states);
+
+    /**
+     * Tell which limit has been exceeded
+     */
+    Reason reason() const;
+
+    /**
+     * Give the number of states created before the transformation was stopped
+     */
+    std::size_t states() const;
+
+  private:
+    Reason limitReason;
+    std::size_t createdStates;
+  };
+
+  /**
+   * Text formats of Automaton::parse() and Automaton::write(), one line per transition
+   */
+  enum class Format {
+    Ba, // Optional "[0]" line for the initial state, then "a,[0]->[1]" lines for the transitions, then "[1]" lines for the final states
+    Att, // AT&T FSM : "0 1 a" lines for the transitions, the origin of the first one being the initial state, then "1" lines for the final states
+  };
+
+  /**
+   * Error thrown when a text doesn't follow its format
+   */
+  class ParseError : public std::runtime_error {
+
+  public:
+    ParseError(std::size_t line, const std::string& message);
+
+    /**
+     * Give the number of the line of the error, from 1
+     */
+    std::size_t line() const;
+
+  private:
+    std::size_t errorLine;
+  };
+
   class Automaton {
 
   public:
@@ -139,15 +293,54 @@ namespace fa {
      */
     std::size_t countTransitions() const;
 
+    /**
+     * Give the memory used by the automaton
+     */
+    MemoryUsage memoryUsage() const;
+
+    /**
+     * Release the memory kept by the containers beyond what they hold, for example after removing many states
+     */
+    void shrinkToFit();
+
     /**
      * Print the automaton in a friendly way
      */
-    void prettyPrint(std::ostream& os) const;
+    void prettyPrint(std::ostream& os, const PrintOptions& options = PrintOptions()) const;
 
     /**
      * Print the automaton with respect to the DOT specification
      */
-    void dotPrint(std::ostream& os) const;
+    void dotPrint(std::ostream& os, const PrintOptions& options = PrintOptions()) const;
+
+    /**
+     * Write the automaton in a text format, that parse() reads back.
+     *
+     * The isolated states are not written. Returns false, without writing anything,
+     * if the format cannot express the automaton : Ba and Att have exactly one initial state,
+     * which must have a transition in Att, Ba has no epsilon-transition, and every symbol of the alphabet has a transition.
+     */
+    bool write(std::ostream& os, Format format) const;
+
+    /**
+     * Write a self-contained C++ source with an inline function bool match(std::string_view) that accepts the language of the automaton.
+     *
+     * The generated code implements the minimal deterministic automaton, without the state from which no final state can be reached.
+     */
+    void emitCpp(std::ostream& os, const EmitOptions& options = EmitOptions()) const;
+
+    /**
+     * Read an automaton in a text format.
+     *
+     * The states are numbers, and the letters are single characters ("<eps>" for an epsilon-transition in Att).
+     * Throws ParseError with the number of the line if the text doesn't follow the format.
+     */
+    static Automaton parse(std::string_view text, Format format);
+
+    /**
+     * Read an automaton in a text format from the whole stream, by blocks of lines (see parse(std::string_view, Format))
+     */
+    static Automaton parse(std::istream& in, Format format);
 
     /**
      * Tell if the automaton has one or more epsilon-transition
@@ -179,26 +372,79 @@ namespace fa {
      */
     bool isLanguageEmpty() const;
 
+    /**
+     * Compute a word of minimal length accepted by the automaton
+     *
+     * The epsilon-transitions are followed without reading a letter.
+     * Returns false if the language is empty, and the word is left untouched.
+     */
+    bool shortestWord(std::string& word) const;
+
+    /**
+     * Count the number of words of the given length accepted by the automaton
+     *
+     * The count saturates: if it does not fit, the maximum std::uint64_t value is returned.
+     */
+    std::uint64_t countWords(std::size_t length) const;
+
+    /**
+     * Give each accepted word of length at most maxLength to the visitor, in shortlex order
+     *
+     * The words are built one at a time. The enumeration stops as soon as the visitor returns false.
+     */
+    void enumerate(std::size_t maxLength, const std::function<bool(const std::string&)>& visitor) const;
+
     /**
      * Tell if the intersection with another automaton is empty
+     *
+     * If the intersection is not empty and witness is not null, it receives a shortest
+     * word accepted by both automata.
      */
-    bool hasEmptyIntersectionWith(const Automaton& other) const;
+    bool hasEmptyIntersectionWith(const Automaton& other, std::string* witness = nullptr) const;
 
     /**
-     * Read the string and compute the state set after traversing the automaton
+     * Read the string and compute the state set after traversing the automaton, the epsilon-transitions included
      */
     std::set<int> readString(const std::string& word) const;
 
     /**
-     * Tell if the word is in the language accepted by the automaton
+     * Tell if the word is in the language accepted by the automaton, following the epsilon-transitions
      */
     bool match(const std::string& word) const;
 
     /**
      * Tell if the langage accepted by the automaton is included in the
      * language accepted by the other automaton
+     *
+     * If the language is not included and counterexample is not null, it receives a
+     * shortest word accepted by the automaton but not by the other one.
+     */
+    bool isIncludedIn(const Automaton& other, std::string* counterexample = nullptr) const;
+
+    /**
+     * Tell if the language accepted by the automaton is the same as the
+     * language accepted by the other automaton
+     *
+     * If the languages differ and counterexample is not null, it receives a word
+     * accepted by only one of the two automata.
+     */
+    bool isEquivalentTo(const Automaton& other, std::string* counterexample = nullptr) const;
+
+    /**
+     * Replace the automaton by its canonical form
+     *
+     * The canonical form is the minimal complete deterministic automaton, whose states are
+     * numbered from 0 in breadth-first order, following the letters in alphabetical order.
+     * Two automata with the same alphabet and the same language have the same canonical form.
+     */
+    void canonicalize();
+
+    /**
+     * Compute a hash of the language, from the canonical form of the automaton
+     *
+     * Two automata with the same alphabet and the same language have the same hash.
      */
-    bool isIncludedIn(const Automaton& other) const;
+    Hash128 languageHash() const;
 
     /**
      * Create a mirror automaton
@@ -212,8 +458,10 @@ namespace fa {
 
     /**
      * Create a complement automaton
+     *
+     * Throws LimitExceeded if the determinization goes beyond the limits.
      */
-    static Automaton createComplement(const Automaton& automaton);
+    static Automaton createComplement(const Automaton& automaton, const Limits& limits = Limits());
 
     /**
      * Create the product of two automata
@@ -222,26 +470,147 @@ namespace fa {
      */
     static Automaton createProduct(const Automaton& lhs, const Automaton& rhs);
 
+    /**
+     * Create the product of several automata at once
+     *
+     * Only the reachable tuples of states are built, without any intermediate product.
+     * If trim is true, the tuples where one of the states cannot reach a final state are dropped.
+     * Throws LimitExceeded if the product goes beyond the limits.
+     */
+    static Automaton createProduct(const std::vector<Automaton>& automata, bool trim = false, const Limits& limits = Limits());
+
+    /**
+     * Create the product of the pointed automata, like the product of several automata, without copying them
+     */
+    static Automaton createProduct(const std::vector<const Automaton*>& automata, bool trim = false, const Limits& limits = Limits());
+
+    /**
+     * Create the canonical form of an automaton (see canonicalize())
+     */
+    static Automaton createCanonical(const Automaton& other);
+
     /**
      * Create a deterministic automaton, if not already deterministic
+     *
+     * Throws LimitExceeded if the determinization goes beyond the limits.
+     */
+    static Automaton createDeterministic(const Automaton& other, const Limits& limits = Limits());
+
+    /**
+     * Create a deterministic automaton, if not already deterministic, using several threads
+     *
+     * The states are numbered as createDeterministic() does. If threads is 0, one thread per core is used.
+     * Throws LimitExceeded if the determinization goes beyond the limits.
+     */
+    static Automaton createDeterministicParallel(const Automaton& other, unsigned threads = 0, const Limits& limits = Limits());
+
+    /**
+     * Give an upper bound of the number of states of the deterministic automaton, without building it
      */
-    static Automaton createDeterministic(const Automaton& other);
+    static std::size_t estimateDeterministicStates(const Automaton& other);
 
     /**
      * Create an equivalent minimal automaton with the Moore algorithm
+     *
+     * Throws LimitExceeded if the transformation goes beyond the limits.
+     */
+    static Automaton createMinimalMoore(const Automaton& other, const Limits& limits = Limits());
+
+    /**
+     * Create an equivalent minimal automaton with the Moore algorithm, using several threads
+     *
+     * Each refinement round is split between the threads. The states are numbered as
+     * createMinimalMoore() does. If threads is 0, one thread per core is used.
+     * Throws LimitExceeded if the transformation goes beyond the limits.
      */
-    static Automaton createMinimalMoore(const Automaton& other);
+    static Automaton createMinimalMooreParallel(const Automaton& other, unsigned threads = 0, const Limits& limits = Limits());
 
     /**
      * Create an equivalent minimal automaton with the Brzozowski algorithm
+     *
+     * Throws LimitExceeded if one of the determinizations goes beyond the limits.
      */
-    static Automaton createMinimalBrzozowski(const Automaton& other);
+    static Automaton createMinimalBrzozowski(const Automaton& other, const Limits& limits = Limits());
 
 
   private:
+    friend class WordSampler;
+    friend class OperationCache;
+    friend class BitParallelMatcher;
+    friend class DfaMatcher;
+    friend class TokenAutomaton;
+    friend class SymbolicAutomaton;
+
+    /**
+     * Builder of the automaton read by parse()
+     */
+    struct TextReader;
+
+    /**
+     * Deterministic automaton stored as a transition table, the states being numbered from 0
+     */
+    struct Table{
+      std::vector<char> letters; // The sorted alphabet
+      std::vector<int> next; // next[state * letters.size() + letter], -1 if there is no transition
+      std::vector<bool> finals;
+      int initial;
+    };
+
+    /**
+     * Transition stored with its origin state, the target being a dense index
+     */
+    struct Transition{
+      char alpha;
+      int to;
+    };
+
+    /**
+     * Set of dense indexes, one bit per index
+     */
+    struct IndexSet{
+      std::vector<std::uint64_t> words;
+
+      bool test(std::size_t index) const;
+      void insert(std::size_t index);
+      void erase(std::size_t index);
+      void resize(std::size_t count); // The new indexes are not in the set
+      bool any() const;
+      bool intersects(const IndexSet& other) const;
+    };
+
     std::set<char> alphabet; //Tab of character > an alphabet
-    std::map<int, State> map_states; //Map of states : <int -> value of the state, State -> struct(int value, bool isInitial, bool isFinal)
-    std::multimap<int, Arc> map_arcs; //Unordered multipmap of arcs :
+    std::vector<int> values; //Number of the state of each dense index, from 0 to countStates() - 1, in the order they were added
+    std::unordered_map<int, int> indexes; //Dense index of each state : <int -> value of the state, int -> index in values>
+    IndexSet initial_states;
+    IndexSet final_states;
+    std::vector<int> initials; //Sorted dense indexes of the initial states
+    std::vector<std::vector<Transition>> transitions; //Outgoing transitions of each dense index
+    std::size_t transition_count;
+
+    /**
+     * Give the dense index of a state, or -1 if there is no such state
+     */
+    int indexOf(int state) const;
+
+    /**
+     * Add a state that doesn't exist yet, and give its dense index
+     */
+    int appendState(int state, bool isInitial, bool isFinal);
+
+    /**
+     * Add a transition between dense indexes, without checking if it already exists
+     */
+    void appendTransition(int from, char alpha, int to);
+
+    /**
+     * Make the state with this dense index initial
+     */
+    void setIndexInitial(int index);
+
+    /**
+     * Remove the states whose index isn't kept, with their transitions, the other states keeping their order
+     */
+    void keepIndexes(const IndexSet& kept);
 
     /**
      * Unset the state Final
@@ -249,24 +618,945 @@ namespace fa {
     void unsetStateFinal(int state);
 
     /**
-     * Recursive function who runs into the automaton to find a path to a final state
+     * Tell if the word is accepted, the set of current states being kept in Words machine words
+     */
+    template<std::size_t Words>
+    bool matchWords(const std::string& word) const;
+
+    /**
+     * Compute the dense indexes reachable from the initial states
+     */
+    IndexSet accessibleIndexes() const;
+
+    /**
+     * Compute the dense indexes from which a final state can be reached
+     */
+    IndexSet coAccessibleIndexes() const;
+
+    /**
+     * Compute the sorted set of dense indexes reached from a set of dense indexes by reading a letter
+     */
+    std::vector<int> successorsOf(const std::vector<int>& from, char alpha) const;
+
+    /**
+     * Add to a sorted set of dense indexes the ones reached by epsilon-transitions
+     */
+    void closeIndexes(std::vector<int>& indexes) const;
+
+    /**
+     * Build the transition table of the deterministic version of the automaton
+     */
+    Table createTable() const;
+
+    /**
+     * Write the alphabet, the final states and the transitions of a canonical automaton as bytes
+     */
+    std::string canonicalBytes() const;
+
+    /**
+     * Write the alphabet, the states and the transitions, as they are, as bytes
+     */
+    std::string structuralBytes() const;
+
+    /**
+     * Compute a hash of the alphabet, the states and the transitions, as they are
+     */
+    Hash128 structuralHash() const;
+
+    /**
+     * Compute, for each length up to maxLength, the saturated number of accepted words starting from each state of the table
+     */
+    static std::vector<std::vector<std::uint64_t>> countSuffixes(const Table& table, std::size_t maxLength);
+  };
+
+  /**
+   * Cache of the results of the transformations of automata, with a memory limit
+   *
+   * Once installed, the cache is used by createDeterministic(), createComplement(),
+   * createMinimalMoore() and thus isIncludedIn(). The results are found back from a hash
+   * of the structure of the transformed automaton. When the memory limit is reached,
+   * the least recently used results are removed. All the functions are thread-safe.
+   */
+  class OperationCache {
+
+  public:
+    enum class Operation { Deterministic, Complement, MinimalMoore };
+
+    /**
+     * Build an empty cache, that keeps results up to about maxBytes of memory
+     */
+    explicit OperationCache(std::size_t maxBytes);
+
+    /**
+     * Use the cache in all the transformations, or no cache if cache is null.
+     *
+     * The cache is not owned, and must be uninstalled before being destroyed. Installing another cache, or null,
+     * waits for the transformations that use the previous cache to finish.
+     */
+    static void install(OperationCache* cache);
+
+    /**
+     * Give the installed cache, or null if there is none
+     */
+    static OperationCache* installed();
+
+    /**
+     * Remove all the results
+     */
+    void clear();
+
+    /**
+     * Count the results in the cache
+     */
+    std::size_t countEntries() const;
+
+    /**
+     * Give the approximate memory used by the results in the cache
+     */
+    std::size_t countBytes() const;
+
+    /**
+     * Count the results found in the cache, and the results that had to be computed
+     */
+    std::size_t countHits() const;
+    std::size_t countMisses() const;
+
+  private:
+    friend class Automaton;
+
+    struct Entry {
+      Operation operation;
+      Hash128 key;
+      std::string input; // The structural bytes of the transformed automaton, to tell apart two automata with the same hash
+      Automaton result;
+      std::size_t bytes;
+    };
+
+    std::size_t maxBytes;
+    std::size_t bytes;
+    std::size_t hits;
+    std::size_t misses;
+    std::list<Entry> entries; // The most recently used first
+    std::map<std::pair<Operation, Hash128>, std::list<Entry>::iterator> index;
+    mutable std::mutex mutex;
+    std::size_t tickets; // Number of transformations holding a ticket on this cache, guarded by the mutex of install()
+
+    /**
+     * Cache used by a transformation, and the transformed automaton.
+     *
+     * The cache cannot be uninstalled while a ticket on it exists.
+     */
+    struct Ticket {
+      OperationCache* cache = nullptr;
+      std::string input;
+      Hash128 key;
+
+      Ticket() = default;
+      Ticket(const Ticket&) = delete;
+      Ticket& operator=(const Ticket&) = delete;
+      ~Ticket();
+    };
+
+    /**
+     * Look for the result of the operation on the automaton in the installed cache.
+     *
+     * The ticket receives the cache and the hash of the automaton, to store the result afterward.
+     */
+    static bool lookup(Operation operation, const Automaton& automaton, Ticket& ticket, Automaton& result);
+
+    /**
+     * Store the result of the operation in the cache of the ticket, if any
+     */
+    static void store(Operation operation, Ticket& ticket, const Automaton& result);
+  };
+
+  /**
+   * Draw words accepted by an automaton, uniformly among the accepted words of a given length
+   */
+  class WordSampler {
+
+  public:
+    /**
+     * Prepare the sampling of the accepted words of length at most maxLength.
+     *
+     * The number of accepted words from each state is computed once here.
+     */
+    WordSampler(const Automaton& automaton, std::size_t maxLength, std::uint64_t seed);
+
+    /**
+     * Restart the random generator with a new seed
+     */
+    void seed(std::uint64_t seed);
+
+    /**
+     * Give the number of accepted words of the given length (saturated), 0 if the length is greater than maxLength
+     */
+    std::uint64_t countWords(std::size_t length) const;
+
+    /**
+     * Draw an accepted word of the given length.
+     *
+     * The word is overwritten in place, so nothing is allocated if its capacity is large enough.
+     * The draw is exactly uniform as long as the number of words fits in a std::uint64_t.
+     * Returns false if no word of this length is accepted, or if the length is greater than maxLength.
+     */
+    bool sample(std::size_t length, std::string& word);
+
+  private:
+    Automaton::Table table;
+    std::vector<std::vector<std::uint64_t>> counts; // counts[length][state] : number of words of this length leading from the state to a final state
+    std::vector<std::vector<std::uint64_t>> prefixes; // prefixes[length][state * letters + letter] : the same for length + 1, counting only the words that begin with this letter or a smaller one
+    std::mt19937_64 generator;
+  };
+
+  /**
+   * Immutable automaton, whose storage is shared by all the copies of the snapshot.
+   *
+   * Copying a snapshot only copies a pointer, and the storage is compacted
+   * once when the snapshot is taken. The automaton can only be reached as
+   * const, so any number of threads can query the same snapshot, or its
+   * copies, at the same time. Converting the last copy of a snapshot back
+   * to an Automaton takes its storage without copying it.
+   */
+  class AutomatonSnapshot {
+
+  public:
+    /**
+     * Build the snapshot of an empty automaton
+     */
+    AutomatonSnapshot();
+
+    /**
+     * Take a snapshot of the automaton, which is moved in when given as an rvalue
+     */
+    explicit AutomatonSnapshot(Automaton automaton);
+
+    /**
+     * Give the automaton, for the read-only queries
      */
-    bool depthFirstSearch(int state, std::set<int> &visited) const;
+    const Automaton& get() const;
+    const Automaton& operator*() const;
+    const Automaton* operator->() const;
 
     /**
-     * Recursive function who runs into the automaton to find a path to a state
+     * Give a mutable copy of the automaton
      */
-    void depthFirstSearch_NonAccessible(int initial, std::set<int> &visited) const;
+    Automaton toAutomaton() const &;
 
     /**
-     * Recursive function who runs into the automaton to find a path to a state
+     * Give a mutable automaton, taking the storage if no other snapshot shares it, and copying it otherwise.
+     *
+     * The snapshot is left empty.
      */
-    void depthFirstSearch_NonCoAccessible(int initial, std::set<int> &visited) const;
+    Automaton toAutomaton() &&;
 
     /**
-     * Recursive function who runs into the automaton to find the last state when we try to go throught the word
+     * Count the snapshots that share the storage of this one, this one included
      */
-    std::set<int> endStateOfWord(int state,const std::string& word) const;
+    std::size_t countShares() const;
+
+  private:
+    std::shared_ptr<Automaton> automaton; // Never null, and never modified while shared
+  };
+
+  /**
+   * Matcher that simulates an automaton of at most MaxStates states, its set of current states being kept in 1, 2 or 4 machine words.
+   *
+   * For each letter and each state, the set of successors is precomputed as a mask, so reading a letter is a union of masks, done with AVX2 for 4 words when the processor has it.
+   * There is no determinization, so the size of the matcher doesn't depend on the language.
+   */
+  class BitParallelMatcher {
+
+  public:
+    static constexpr std::size_t MaxStates = 256;
+
+    /**
+     * Tell if the automaton is small enough for a BitParallelMatcher
+     */
+    static bool fits(const Automaton& automaton);
+
+    /**
+     * Precompute the masks of an automaton that fits.
+     *
+     * Throws std::invalid_argument if the automaton has more than MaxStates states.
+     */
+    explicit BitParallelMatcher(const Automaton& automaton);
+
+    /**
+     * Tell if the word is accepted by the automaton, like Automaton::match()
+     */
+    bool match(const std::string& word) const;
+
+    /**
+     * Give the number of states of the automaton
+     */
+    std::size_t countStates() const;
+
+  private:
+    std::size_t states;
+    std::size_t words; // Number of machine words of a set of states : 1, 2 or 4
+    std::vector<int> letters; // letters[(unsigned char)alpha] : index of the letter in the masks, or -1 if no transition uses it
+    std::vector<std::uint64_t> masks; // Successors of each state : masks[((letter * states) + state) * words + word]
+    std::vector<std::uint64_t> initials;
+    std::vector<std::uint64_t> finals;
+    bool hasAvx2; // The union of the masks of 4 words uses AVX2, checked at run time
+
+    template<std::size_t Words>
+    bool matchWords(const std::string& word) const;
+  };
+
+  /**
+   * Matcher over the transition table of the deterministic version of an automaton, made to read many independent words.
+   *
+   * matchMany() reads several words in lockstep, one per lane, so the loads of the transitions of the different words overlap.
+   * The lanes use AVX-512 or AVX2 gathers when the processor has them, checked at run time, and plain loads otherwise.
+   */
+  class DfaMatcher {
+
+  public:
+    /**
+     * Instruction set used by matchMany()
+     */
+    enum class Kernel {
+      Automatic, // The best one supported by the processor
+      Scalar, // 8 lanes with plain loads
+      Avx2, // 8 lanes with AVX2 gathers
+      Avx512, // 16 lanes with AVX-512 gathers
+    };
+
+    /**
+     * Determinize the automaton and build the table.
+     *
+     * Throws LimitExceeded if the determinization goes beyond the limits.
+     */
+    explicit DfaMatcher(const Automaton& automaton, const Limits& limits = Limits());
+
+    /**
+     * Tell if the word is accepted by the automaton
+     */
+    bool match(const std::string& word) const;
+
+    /**
+     * Tell, for each word, if it is accepted by the automaton.
+     *
+     * An unsupported kernel is replaced by the scalar one.
+     */
+    void matchMany(const std::vector<std::string>& words, std::vector<bool>& accepted, Kernel kernel = Kernel::Automatic) const;
+
+    /**
+     * Tell if the processor supports the kernel
+     */
+    static bool supports(Kernel kernel);
+
+    /**
+     * Give the number of states of the table, including the dead state
+     */
+    std::size_t countStates() const;
+
+  private:
+    std::vector<std::int32_t> columns; // columns[(unsigned char)alpha] : column of the letter in the table, unknown letters going to the dead state
+    std::size_t stride; // Number of columns : the letters, the unknown letters, and the column where every state stays in place
+    std::vector<std::int32_t> next; // next[state * stride + column]
+    std::vector<std::uint8_t> finals;
+    std::int32_t initial;
+  };
+
+
+  /**
+   * Range of Unicode code points, both ends included
+   */
+  struct CodePointRange {
+    char32_t first;
+    char32_t last;
+  };
+
+  /**
+   * Tell if the bytes are a valid UTF-8 text : no overlong encoding, no surrogate, no code point above U+10FFFF and no truncated sequence.
+   *
+   * The bytes are checked 32 at a time with AVX2 when the processor supports it.
+   */
+  bool isValidUtf8(std::string_view bytes);
+
+  /**
+   * Automaton over a large alphabet of 32-bit symbols, like the ids of the tokens of a lexer.
+   *
+   * The transitions of each state are kept sorted by symbol, and the
+   * algorithms only look at the symbols of the existing transitions, so
+   * their cost doesn't depend on the size of the alphabet. There is no
+   * epsilon-transition.
+   */
+  class TokenAutomaton {
+  public:
+    using Symbol = std::uint32_t;
+
+    /**
+     * Build an empty automaton (no symbol, no state, no transition).
+     */
+    TokenAutomaton();
+
+    /**
+     * Build the automaton over the bytes equivalent to an automaton without epsilon-transition, each letter being a symbol
+     */
+    static TokenAutomaton fromAutomaton(const Automaton& automaton);
+
+    /**
+     * Tell if the automaton is valid : it has at least one symbol and one state
+     */
+    bool isValid() const;
+
+    /**
+     * Add a symbol to the automaton. Returns false if the symbol is already there.
+     */
+    bool addSymbol(Symbol symbol);
+
+    /**
+     * Tell if the symbol is in the alphabet
+     */
+    bool hasSymbol(Symbol symbol) const;
+
+    /**
+     * Count the symbols in the alphabet
+     */
+    std::size_t countSymbols() const;
+
+    /**
+     * Add a state to the automaton. Returns false if the state is negative or already there.
+     */
+    bool addState(int state);
+
+    /**
+     * Tell if the state is in the automaton
+     */
+    bool hasState(int state) const;
+
+    /**
+     * Count the states of the automaton
+     */
+    std::size_t countStates() const;
+
+    /**
+     * Set a state initial
+     */
+    void setStateInitial(int state);
+
+    /**
+     * Tell if the state is initial
+     */
+    bool isStateInitial(int state) const;
+
+    /**
+     * Set a state final
+     */
+    void setStateFinal(int state);
+
+    /**
+     * Tell if the state is final
+     */
+    bool isStateFinal(int state) const;
+
+    /**
+     * Add a transition. Returns false if a state or the symbol is missing, or if the transition is already there.
+     */
+    bool addTransition(int from, Symbol symbol, int to);
+
+    /**
+     * Remove a transition. Returns false if the transition is not there.
+     */
+    bool removeTransition(int from, Symbol symbol, int to);
+
+    /**
+     * Tell if the transition is in the automaton
+     */
+    bool hasTransition(int from, Symbol symbol, int to) const;
+
+    /**
+     * Count the transitions of the automaton
+     */
+    std::size_t countTransitions() const;
+
+    /**
+     * Tell if the automaton is deterministic
+     */
+    bool isDeterministic() const;
+
+    /**
+     * Tell if the automaton accepts no word
+     */
+    bool isLanguageEmpty() const;
+
+    /**
+     * Tell if the word is accepted by the automaton
+     */
+    bool match(const std::vector<Symbol>& word) const;
+
+    /**
+     * Tell if the bytes are accepted by the automaton, each byte being the symbol of its value.
+     *
+     * The sets of states are followed like match() does ; ByteMatcher compiles the automaton to read many texts.
+     */
+    bool matchBytes(std::string_view bytes) const;
+
+    /**
+     * Compile an automaton over ranges of code points into an automaton over the bytes of their UTF-8 encoding.
+     *
+     * Each symbol s of the automaton stands for the code points of ranges[s], the surrogates excepted. The states
+     * keep their numbers, and the states added for the continuation bytes are shared by the sequences with the same
+     * end. The result may not be deterministic. Throws std::invalid_argument if a symbol has no valid range, like a
+     * range made of surrogates only.
+     */
+    static TokenAutomaton createUtf8(const TokenAutomaton& automaton, const std::vector<CodePointRange>& ranges);
+
+    /**
+     * Create a deterministic automaton with the same language, the states being numbered in breadth-first order.
+     *
+     * Throws LimitExceeded if the determinization goes beyond the limits.
+     */
+    static TokenAutomaton createDeterministic(const TokenAutomaton& other, const Limits& limits = Limits());
+
+    /**
+     * Create the product of two automata, whose language is the intersection of their languages
+     */
+    static TokenAutomaton createProduct(const TokenAutomaton& lhs, const TokenAutomaton& rhs, const Limits& limits = Limits());
+
+    /**
+     * Create the minimal deterministic automaton, without the state from which no final state can be reached.
+     *
+     * The result is not complete, a missing transition rejecting the word.
+     */
+    static TokenAutomaton createMinimal(const TokenAutomaton& other, const Limits& limits = Limits());
+
+  private:
+    friend class ByteMatcher;
+
+    /**
+     * Transition stored with its origin state, the target being a dense index
+     */
+    struct Transition {
+      Symbol symbol;
+      int to;
+    };
+
+    std::vector<Symbol> alphabet; // Sorted
+    std::vector<int> values;
+    std::unordered_map<int, int> indexes;
+    std::vector<bool> initial_states;
+    std::vector<bool> final_states;
+    std::vector<std::vector<Transition>> transitions; // Sorted by symbol, then by target
+    std::size_t transition_count;
+
+    int indexOf(int state) const;
+    int appendState(int state, bool isInitial, bool isFinal);
+    void successorsOf(const std::vector<int>& from, Symbol symbol, std::vector<int>& to) const;
+
+    template<typename Iterator>
+    bool matchSymbols(Iterator first, Iterator last) const;
+  };
+
+  /**
+   * Matcher over the bytes of a text, compiled from a TokenAutomaton over bytes like the one of TokenAutomaton::createUtf8().
+   *
+   * The automaton is determinized into a table of 256 columns, so reading a byte is one load. The symbols
+   * above 255 are not bytes and are left out.
+   */
+  class ByteMatcher {
+
+  public:
+    /**
+     * Determinize the automaton and build the table.
+     *
+     * Throws LimitExceeded if the determinization goes beyond the limits.
+     */
+    explicit ByteMatcher(const TokenAutomaton& automaton, const Limits& limits = Limits());
+
+    /**
+     * Tell if the bytes are accepted by the automaton
+     */
+    bool match(std::string_view bytes) const;
+
+    /**
+     * Give the number of states of the table, including the dead state
+     */
+    std::size_t countStates() const;
+
+  private:
+    std::vector<std::int32_t> next; // next[state * 256 + byte], the missing transitions going to the dead state
+    std::vector<std::uint8_t> finals;
+    std::int32_t initial;
+  };
+
+  /**
+   * Set of 32-bit symbols, stored as sorted and disjoint intervals
+   */
+  class SymbolSet {
+  public:
+    using Symbol = std::uint32_t;
+
+    /**
+     * Interval of symbols, both ends included
+     */
+    struct Interval {
+      Symbol first;
+      Symbol last;
+    };
+
+    /**
+     * Build an empty set
+     */
+    SymbolSet();
+
+    /**
+     * Build the set of the symbols from first to last, empty if last is before first
+     */
+    static SymbolSet range(Symbol first, Symbol last);
+
+    /**
+     * Build the set of one symbol
+     */
+    static SymbolSet single(Symbol symbol);
+
+    /**
+     * Build the set of all the symbols
+     */
+    static SymbolSet all();
+
+    /**
+     * Build the set of the symbols of the intervals, which may overlap and be in any order
+     */
+    static SymbolSet fromIntervals(std::vector<Interval> intervals);
+
+    bool isEmpty() const;
+    bool contains(Symbol symbol) const;
+
+    /**
+     * Count the symbols of the set, all() having 2^32 symbols
+     */
+    std::uint64_t countSymbols() const;
+
+    SymbolSet unionWith(const SymbolSet& other) const;
+    SymbolSet intersectionWith(const SymbolSet& other) const;
+    SymbolSet complement() const;
+
+    /**
+     * Give the sorted and disjoint intervals of the set, two intervals never being adjacent
+     */
+    const std::vector<Interval>& getIntervals() const;
+
+    bool operator==(const SymbolSet& other) const;
+    bool operator!=(const SymbolSet& other) const;
+
+  private:
+    std::vector<Interval> intervals;
+  };
+
+  /**
+   * Automaton whose transitions are labelled by sets of 32-bit symbols.
+   *
+   * A transition like "any symbol except x" is one transition, whatever the
+   * number of symbols. There is at most one transition from a state to
+   * another, whose set is the union of the added ones. The transformations
+   * work on the minterms : the largest sets of symbols that no transition
+   * separates. A missing symbol rejects the word, as if it led to a dead state.
+   */
+  class SymbolicAutomaton {
+  public:
+    using Symbol = SymbolSet::Symbol;
+
+    /**
+     * Build an empty automaton (no state, no transition).
+     */
+    SymbolicAutomaton();
+
+    /**
+     * Build the equivalent automaton of an automaton without epsilon-transition, each letter being the symbol of its byte value
+     */
+    static SymbolicAutomaton fromAutomaton(const Automaton& automaton);
+
+    /**
+     * Tell if the automaton is valid : it has at least one state
+     */
+    bool isValid() const;
+
+    /**
+     * Add a state to the automaton. Returns false if the state is negative or already there.
+     */
+    bool addState(int state);
+
+    /**
+     * Tell if the state is in the automaton
+     */
+    bool hasState(int state) const;
+
+    /**
+     * Count the states of the automaton
+     */
+    std::size_t countStates() const;
+
+    /**
+     * Set a state initial
+     */
+    void setStateInitial(int state);
+
+    /**
+     * Tell if the state is initial
+     */
+    bool isStateInitial(int state) const;
+
+    /**
+     * Set a state final
+     */
+    void setStateFinal(int state);
+
+    /**
+     * Tell if the state is final
+     */
+    bool isStateFinal(int state) const;
+
+    /**
+     * Add the symbols to the transition from a state to another. Returns false if a state is missing or the set is empty.
+     */
+    bool addTransition(int from, const SymbolSet& symbols, int to);
+
+    /**
+     * Give the symbols of the transition from a state to another, empty if there is none
+     */
+    SymbolSet getTransition(int from, int to) const;
+
+    /**
+     * Count the transitions of the automaton, one per pair of states at most
+     */
+    std::size_t countTransitions() const;
+
+    /**
+     * Tell if the automaton is deterministic : one initial state, and disjoint sets on the transitions of each state
+     */
+    bool isDeterministic() const;
+
+    /**
+     * Tell if each state has a transition for every symbol
+     */
+    bool isComplete() const;
+
+    /**
+     * Tell if the automaton accepts no word
+     */
+    bool isLanguageEmpty() const;
+
+    /**
+     * Tell if the word is accepted by the automaton
+     */
+    bool match(const std::vector<Symbol>& word) const;
+
+    /**
+     * Create a complete automaton with the same language, adding at most one state and one transition per state
+     */
+    static SymbolicAutomaton createComplete(const SymbolicAutomaton& other);
+
+    /**
+     * Create a deterministic automaton with the same language, the states being numbered in breadth-first order.
+     *
+     * Throws LimitExceeded if the determinization goes beyond the limits.
+     */
+    static SymbolicAutomaton createDeterministic(const SymbolicAutomaton& other, const Limits& limits = Limits());
+
+    /**
+     * Create the product of two automata, whose language is the intersection of their languages
+     */
+    static SymbolicAutomaton createProduct(const SymbolicAutomaton& lhs, const SymbolicAutomaton& rhs, const Limits& limits = Limits());
+
+    /**
+     * Create the minimal deterministic automaton, without the state from which no final state can be reached
+     */
+    static SymbolicAutomaton createMinimal(const SymbolicAutomaton& other, const Limits& limits = Limits());
+
+  private:
+    /**
+     * Transition stored with its origin state, the target being a dense index
+     */
+    struct Transition {
+      SymbolSet symbols;
+      int to;
+    };
+
+    std::vector<int> values;
+    std::unordered_map<int, int> indexes;
+    std::vector<bool> initial_states;
+    std::vector<bool> final_states;
+    std::vector<std::vector<Transition>> transitions; // Sorted by target
+
+    int indexOf(int state) const;
+    int appendState(int state, bool isInitial, bool isFinal);
+    void appendTransition(int from, const SymbolSet& symbols, int to);
+  };
+
+  /**
+   * Deterministic automaton of fixed size that can be built and used at compile time.
+   *
+   * NStates is the number of states and NLetters the size of the alphabet.
+   * A missing transition rejects the word. The automaton is usually built
+   * in a constexpr lambda, so that the table is part of the binary:
+   *
+   *   constexpr auto hex = [] {
+   *     fa::StaticDfa<2, 3> dfa("01x");
+   *     dfa.setStateFinal(1);
+   *     ...
+   *     return dfa;
+   *   }();
+   *   static_assert(hex.match("0x1"));
+   */
+  template<std::size_t NStates, std::size_t NLetters>
+  class StaticDfa {
+  public:
+    static_assert(NStates > 0, "A static automaton needs at least one state");
+    static_assert(NStates <= INT32_MAX, "Too many states for a static automaton");
+
+    /**
+     * Build an automaton with the letters of the alphabet, no transition and 0 as initial state.
+     *
+     * Throws std::invalid_argument if the alphabet does not have NLetters different letters,
+     * or if a letter is not printable without being a space, like the letters of Automaton.
+     */
+    constexpr explicit StaticDfa(std::string_view alphabet) {
+      if (alphabet.size() != NLetters) {
+        throw std::invalid_argument("The alphabet does not have the expected size");
+      }
+      for (std::size_t letter = 0; letter < NLetters; ++letter) {
+        unsigned char alpha = static_cast<unsigned char>(alphabet[letter]);
+        // The characters accepted by isgraph() in the C locale, which isn't constexpr
+        if (alpha < '!' || alpha > '~') {
+          throw std::invalid_argument("The alphabet has an invalid letter");
+        }
+        if (columns[alpha] != 0) {
+          throw std::invalid_argument("The alphabet has a letter twice");
+        }
+        columns[alpha] = static_cast<std::uint16_t>(letter + 1);
+      }
+      for (std::size_t state = 0; state < NStates; ++state) {
+        for (std::size_t column = 0; column <= NLetters; ++column) {
+          next[state][column] = -1;
+        }
+      }
+    }
+
+    /**
+     * Add a transition.
+     *
+     * Throws std::invalid_argument if a state or the letter is unknown, or
+     * if the state already has another transition with this letter. In a
+     * constant expression, this is a compilation error.
+     */
+    constexpr void addTransition(int from, char alpha, int to) {
+      checkState(from);
+      checkState(to);
+      std::size_t column = columns[static_cast<unsigned char>(alpha)];
+      if (column == 0) {
+        throw std::invalid_argument("The letter is not in the alphabet");
+      }
+      if (next[from][column] != -1 && next[from][column] != to) {
+        throw std::invalid_argument("The automaton would not be deterministic");
+      }
+      next[from][column] = to;
+    }
+
+    /**
+     * Set the initial state
+     */
+    constexpr void setStateInitial(int state) {
+      checkState(state);
+      initial = state;
+    }
+
+    /**
+     * Set a state final
+     */
+    constexpr void setStateFinal(int state) {
+      checkState(state);
+      finals[state] = true;
+    }
+
+    /**
+     * Tell if a state is final
+     */
+    constexpr bool isStateFinal(int state) const {
+      checkState(state);
+      return finals[state];
+    }
+
+    /**
+     * Give the state reached from a state with a letter, or -1 if there is no transition
+     */
+    constexpr int getTransition(int from, char alpha) const {
+      checkState(from);
+      return next[from][columns[static_cast<unsigned char>(alpha)]];
+    }
+
+    /**
+     * Tell if the word is accepted by the automaton
+     */
+    constexpr bool match(std::string_view word) const {
+      int state = initial;
+      for (char alpha : word) {
+        state = next[state][columns[static_cast<unsigned char>(alpha)]];
+        if (state < 0) {
+          return false;
+        }
+      }
+      return finals[state];
+    }
+
+    /**
+     * Give the number of states
+     */
+    static constexpr std::size_t countStates() {
+      return NStates;
+    }
+
+    /**
+     * Give the size of the alphabet
+     */
+    static constexpr std::size_t countSymbols() {
+      return NLetters;
+    }
+
+    /**
+     * Build the equivalent runtime automaton, with the states numbered from 0 to NStates - 1
+     */
+    Automaton toAutomaton() const {
+      Automaton fa;
+      for (std::size_t alpha = 0; alpha < 256; ++alpha) {
+        if (columns[alpha] != 0) {
+          fa.addSymbol(static_cast<char>(alpha));
+        }
+      }
+      for (std::size_t state = 0; state < NStates; ++state) {
+        fa.addState(static_cast<int>(state));
+        if (finals[state]) {
+          fa.setStateFinal(static_cast<int>(state));
+        }
+      }
+      fa.setStateInitial(initial);
+      for (std::size_t state = 0; state < NStates; ++state) {
+        for (std::size_t alpha = 0; alpha < 256; ++alpha) {
+          std::size_t column = columns[alpha];
+          if (column != 0 && next[state][column] != -1) {
+            fa.addTransition(static_cast<int>(state), static_cast<char>(alpha), next[state][column]);
+          }
+        }
+      }
+      return fa;
+    }
+
+  private:
+    constexpr void checkState(int state) const {
+      if (state < 0 || static_cast<std::size_t>(state) >= NStates) {
+        throw std::invalid_argument("The state does not exist");
+      }
+    }
+
+  private:
+    std::uint16_t columns[256] = {}; // columns[(unsigned char)alpha] : column of the letter, 0 for the letters out of the alphabet
+    int next[NStates][NLetters + 1] = {}; // next[state][column], -1 if there is no transition
+    bool finals[NStates] = {};
+    int initial = 0;
   };
 
 }
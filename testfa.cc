@@ -3684,6 +3684,2337 @@ TEST(PrettyPrint, ShowThePrettyPrint){  fa::Automaton fa;
   fa.prettyPrint(std::cout);
 }
 
+// -------------------------------------------------------------------- CreateProduct N-ary
+
+TEST(AutomatonCreateProductNAry, ThreeAutomata) {
+  // Words with an even number of a
+  fa::Automaton evenA;
+  evenA.addSymbol('a');
+  evenA.addSymbol('b');
+  evenA.addState(0);
+  evenA.addState(1);
+  evenA.setStateInitial(0);
+  evenA.setStateFinal(0);
+  evenA.addTransition(0,'a',1);
+  evenA.addTransition(1,'a',0);
+  evenA.addTransition(0,'b',0);
+  evenA.addTransition(1,'b',1);
+
+  // Words ending with b
+  fa::Automaton endB;
+  endB.addSymbol('a');
+  endB.addSymbol('b');
+  endB.addState(0);
+  endB.addState(1);
+  endB.setStateInitial(0);
+  endB.setStateFinal(1);
+  endB.addTransition(0,'a',0);
+  endB.addTransition(0,'b',0);
+  endB.addTransition(0,'b',1);
+
+  // Words of length at most 3
+  fa::Automaton shortWords;
+  shortWords.addSymbol('a');
+  shortWords.addSymbol('b');
+  for(int i = 0; i <= 3; i++){
+    shortWords.addState(i);
+    shortWords.setStateFinal(i);
+  }
+  shortWords.setStateInitial(0);
+  for(int i = 0; i < 3; i++){
+    shortWords.addTransition(i,'a',i+1);
+    shortWords.addTransition(i,'b',i+1);
+  }
+
+  fa::Automaton product = fa::Automaton::createProduct({evenA, endB, shortWords});
+  EXPECT_TRUE(product.isValid());
+  EXPECT_TRUE(product.match("b"));
+  EXPECT_TRUE(product.match("aab"));
+  EXPECT_TRUE(product.match("bbb"));
+  EXPECT_FALSE(product.match(""));
+  EXPECT_FALSE(product.match("ab"));
+  EXPECT_FALSE(product.match("aabb"));
+  EXPECT_FALSE(product.match("aa"));
+
+  fa::Automaton twoSteps = fa::Automaton::createProduct(fa::Automaton::createProduct(evenA, endB), shortWords);
+  EXPECT_EQ(twoSteps.countStates(), product.countStates());
+  EXPECT_EQ(twoSteps.countTransitions(), product.countTransitions());
+
+  fa::Automaton pointed = fa::Automaton::createProduct(std::vector<const fa::Automaton*>{&evenA, &endB, &shortWords});
+  EXPECT_EQ(product.countStates(), pointed.countStates());
+  EXPECT_EQ(product.countTransitions(), pointed.countTransitions());
+  EXPECT_TRUE(pointed.isEquivalentTo(product));
+}
+
+TEST(AutomatonCreateProductNAry, SameAsBinaryProduct) {
+  fa::Automaton lhs;
+  lhs.addSymbol('a');
+  lhs.addSymbol('b');
+  lhs.addState(1);
+  lhs.addState(2);
+  lhs.addState(3);
+  lhs.setStateInitial(1);
+  lhs.setStateFinal(3);
+  lhs.addTransition(1,'a',3);
+  lhs.addTransition(1,'a',2);
+  lhs.addTransition(1,'b',3);
+
+  fa::Automaton binary = fa::Automaton::createProduct(lhs, lhs);
+  fa::Automaton nary = fa::Automaton::createProduct({lhs, lhs});
+  EXPECT_EQ(binary.countStates(), nary.countStates());
+  EXPECT_EQ(binary.countTransitions(), nary.countTransitions());
+  EXPECT_TRUE(nary.match("a"));
+  EXPECT_TRUE(nary.match("b"));
+  EXPECT_FALSE(nary.match("ab"));
+}
+
+TEST(AutomatonCreateProductNAry, TrimDeadTuples) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.addState(1);
+  fa.addState(2);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  fa.addTransition(0,'a',1);
+  fa.addTransition(0,'b',2);
+  fa.addTransition(2,'a',2);
+
+  fa::Automaton full = fa::Automaton::createProduct({fa, fa, fa});
+  fa::Automaton trimmed = fa::Automaton::createProduct({fa, fa, fa}, true);
+  EXPECT_EQ(3u, full.countStates());
+  EXPECT_EQ(2u, trimmed.countStates());
+  EXPECT_EQ(1u, trimmed.countTransitions());
+  EXPECT_TRUE(trimmed.match("a"));
+  EXPECT_FALSE(trimmed.match("b"));
+}
+
+TEST(AutomatonCreateProductNAry, EmptyIntersection) {
+  fa::Automaton lhs;
+  lhs.addSymbol('a');
+  lhs.addState(0);
+  lhs.setStateInitial(0);
+  lhs.setStateFinal(0);
+
+  fa::Automaton rhs;
+  rhs.addSymbol('b');
+  rhs.addState(0);
+  rhs.setStateInitial(0);
+  rhs.addTransition(0,'b',0);
+
+  fa::Automaton product = fa::Automaton::createProduct({lhs, rhs, lhs}, true);
+  EXPECT_TRUE(product.isValid());
+  EXPECT_TRUE(product.isLanguageEmpty());
+}
+
+// -------------------------------------------------------------------- IsEquivalentTo
+
+TEST(IsEquivalentTo, NonDeterministicAndMinimal) {
+  // Words ending with ab
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.addState(1);
+  fa.addState(2);
+  fa.setStateInitial(0);
+  fa.setStateFinal(2);
+  fa.addTransition(0,'a',0);
+  fa.addTransition(0,'b',0);
+  fa.addTransition(0,'a',1);
+  fa.addTransition(1,'b',2);
+
+  fa::Automaton minimal = fa::Automaton::createMinimalMoore(fa);
+  EXPECT_TRUE(fa.isEquivalentTo(minimal));
+  EXPECT_TRUE(minimal.isEquivalentTo(fa));
+  EXPECT_TRUE(fa.isEquivalentTo(fa::Automaton::createMinimalBrzozowski(fa)));
+  EXPECT_TRUE(fa.isEquivalentTo(fa));
+}
+
+TEST(IsEquivalentTo, DifferentLanguages) {
+  fa::Automaton lhs;
+  lhs.addSymbol('a');
+  lhs.addSymbol('b');
+  lhs.addState(0);
+  lhs.addState(1);
+  lhs.setStateInitial(0);
+  lhs.setStateFinal(1);
+  lhs.addTransition(0,'a',1);
+  lhs.addTransition(1,'a',1);
+  lhs.addTransition(1,'b',1);
+
+  fa::Automaton rhs = lhs;
+  rhs.removeTransition(1,'b',1);
+
+  std::string word;
+  EXPECT_FALSE(lhs.isEquivalentTo(rhs, &word));
+  EXPECT_NE(lhs.match(word), rhs.match(word));
+  EXPECT_EQ(2u, word.size());
+  EXPECT_FALSE(rhs.isEquivalentTo(lhs));
+}
+
+TEST(IsEquivalentTo, EmptyWordDiffers) {
+  fa::Automaton lhs;
+  lhs.addSymbol('a');
+  lhs.addState(0);
+  lhs.setStateInitial(0);
+  lhs.addTransition(0,'a',0);
+
+  fa::Automaton rhs = lhs;
+  rhs.setStateFinal(0);
+
+  std::string word = "not empty";
+  EXPECT_FALSE(lhs.isEquivalentTo(rhs, &word));
+  EXPECT_EQ("", word);
+}
+
+TEST(IsEquivalentTo, DifferentAlphabets) {
+  fa::Automaton lhs;
+  lhs.addSymbol('a');
+  lhs.addState(0);
+  lhs.setStateInitial(0);
+  lhs.setStateFinal(0);
+  lhs.addTransition(0,'a',0);
+
+  fa::Automaton rhs = lhs;
+  rhs.addSymbol('b');
+  EXPECT_TRUE(lhs.isEquivalentTo(rhs));
+
+  rhs.addState(1);
+  rhs.setStateFinal(1);
+  rhs.addTransition(0,'b',1);
+  std::string word;
+  EXPECT_FALSE(lhs.isEquivalentTo(rhs, &word));
+  EXPECT_EQ("b", word);
+}
+
+// -------------------------------------------------------------------- ShortestWord
+
+TEST(ShortestWord, ShortestPathIsChosen) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.addState(1);
+  fa.addState(2);
+  fa.addState(3);
+  fa.setStateInitial(0);
+  fa.setStateFinal(3);
+  fa.addTransition(0,'a',1);
+  fa.addTransition(1,'a',2);
+  fa.addTransition(2,'a',3);
+  fa.addTransition(0,'b',3);
+
+  std::string word;
+  EXPECT_TRUE(fa.shortestWord(word));
+  EXPECT_EQ("b", word);
+}
+
+TEST(ShortestWord, EmptyWord) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(1);
+  fa.setStateFinal(1);
+  fa.addTransition(1,'a',0);
+
+  std::string word = "a";
+  EXPECT_TRUE(fa.shortestWord(word));
+  EXPECT_EQ("", word);
+}
+
+TEST(ShortestWord, EmptyLanguage) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  fa.addTransition(0,'a',0);
+
+  std::string word = "unchanged";
+  EXPECT_FALSE(fa.shortestWord(word));
+  EXPECT_EQ("unchanged", word);
+  EXPECT_TRUE(fa.isLanguageEmpty());
+}
+
+TEST(ShortestWord, EpsilonTransitions) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  for(int state = 0; state < 5; state++){
+    fa.addState(state);
+  }
+  fa.setStateInitial(0);
+  fa.setStateFinal(4);
+  // "aa" through 1 and 2, or "b" through 3 after an epsilon-transition
+  fa.addTransition(0,'a',1);
+  fa.addTransition(1,'a',2);
+  fa.addTransition(2,fa::Epsilon,4);
+  fa.addTransition(0,fa::Epsilon,3);
+  fa.addTransition(3,'b',4);
+
+  std::string word;
+  EXPECT_TRUE(fa.shortestWord(word));
+  EXPECT_EQ("b", word);
+  EXPECT_FALSE(fa.isLanguageEmpty());
+  EXPECT_TRUE(fa.match(word));
+  EXPECT_TRUE(fa.match("aa"));
+  EXPECT_FALSE(fa.match("a"));
+  EXPECT_EQ(std::set<int>({4}), fa.readString("b"));
+  EXPECT_EQ(std::set<int>({2, 4}), fa.readString("aa"));
+
+  fa.removeTransition(3,'b',4);
+  fa.addTransition(3,fa::Epsilon,4);
+  EXPECT_TRUE(fa.shortestWord(word));
+  EXPECT_EQ("", word);
+  EXPECT_TRUE(fa.match(word));
+  EXPECT_EQ(std::set<int>({0, 3, 4}), fa.readString(""));
+}
+
+TEST(ShortestWord, EpsilonTransitionsLargeAutomaton) {
+  // Beyond BitParallelMatcher::MaxStates states, match() reads the sets of states given by readString()
+  const int length = 300;
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  for(int state = 0; state <= length; state++){
+    fa.addState(state);
+  }
+  fa.setStateInitial(0);
+  fa.setStateFinal(length);
+  for(int state = 0; state < length; state++){
+    fa.addTransition(state, state % 3 == 0 ? 'a' : fa::Epsilon, state + 1);
+  }
+
+  std::string word;
+  EXPECT_TRUE(fa.shortestWord(word));
+  EXPECT_EQ(std::string(length / 3, 'a'), word);
+  EXPECT_TRUE(fa.match(word));
+  EXPECT_FALSE(fa.match(word + "a"));
+  EXPECT_FALSE(fa.match(std::string(length / 3 - 1, 'a')));
+}
+
+TEST(ShortestWord, IntersectionWitness) {
+  fa::Automaton lhs;
+  lhs.addSymbol('a');
+  lhs.addSymbol('b');
+  lhs.addState(0);
+  lhs.addState(1);
+  lhs.setStateInitial(0);
+  lhs.setStateFinal(1);
+  lhs.addTransition(0,'a',0);
+  lhs.addTransition(0,'b',1);
+
+  fa::Automaton rhs;
+  rhs.addSymbol('a');
+  rhs.addSymbol('b');
+  rhs.addState(0);
+  rhs.addState(1);
+  rhs.addState(2);
+  rhs.setStateInitial(0);
+  rhs.setStateFinal(2);
+  rhs.addTransition(0,'a',1);
+  rhs.addTransition(1,'a',1);
+  rhs.addTransition(1,'b',2);
+
+  std::string witness;
+  EXPECT_FALSE(lhs.hasEmptyIntersectionWith(rhs, &witness));
+  EXPECT_EQ("ab", witness);
+}
+
+TEST(ShortestWord, InclusionCounterexample) {
+  // a*b
+  fa::Automaton lhs;
+  lhs.addSymbol('a');
+  lhs.addSymbol('b');
+  lhs.addState(0);
+  lhs.addState(1);
+  lhs.setStateInitial(0);
+  lhs.setStateFinal(1);
+  lhs.addTransition(0,'a',0);
+  lhs.addTransition(0,'b',1);
+
+  // a?b
+  fa::Automaton rhs;
+  rhs.addSymbol('a');
+  rhs.addSymbol('b');
+  rhs.addState(0);
+  rhs.addState(1);
+  rhs.addState(2);
+  rhs.setStateInitial(0);
+  rhs.setStateFinal(2);
+  rhs.addTransition(0,'a',1);
+  rhs.addTransition(0,'b',2);
+  rhs.addTransition(1,'b',2);
+
+  std::string counterexample;
+  EXPECT_TRUE(rhs.isIncludedIn(lhs, &counterexample));
+  EXPECT_FALSE(lhs.isIncludedIn(rhs, &counterexample));
+  EXPECT_EQ("aab", counterexample);
+}
+
+// -------------------------------------------------------------------- CountWords
+
+TEST(CountWords, EvenNumberOfA) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateFinal(0);
+  fa.addTransition(0,'a',1);
+  fa.addTransition(1,'a',0);
+  fa.addTransition(0,'b',0);
+  fa.addTransition(1,'b',1);
+
+  EXPECT_EQ(1u, fa.countWords(0));
+  EXPECT_EQ(1u, fa.countWords(1));
+  EXPECT_EQ(2u, fa.countWords(2));
+  EXPECT_EQ(512u, fa.countWords(10));
+}
+
+TEST(CountWords, NonDeterministic) {
+  // Words ending with ab
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.addState(1);
+  fa.addState(2);
+  fa.setStateInitial(0);
+  fa.setStateFinal(2);
+  fa.addTransition(0,'a',0);
+  fa.addTransition(0,'b',0);
+  fa.addTransition(0,'a',1);
+  fa.addTransition(1,'b',2);
+
+  EXPECT_EQ(0u, fa.countWords(1));
+  EXPECT_EQ(1u, fa.countWords(2));
+  EXPECT_EQ(4u, fa.countWords(4));
+}
+
+TEST(CountWords, Saturated) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.setStateInitial(0);
+  fa.setStateFinal(0);
+  fa.addTransition(0,'a',0);
+  fa.addTransition(0,'b',0);
+
+  EXPECT_EQ(std::uint64_t(1) << 63, fa.countWords(63));
+  EXPECT_EQ(std::numeric_limits<std::uint64_t>::max(), fa.countWords(64));
+}
+
+// -------------------------------------------------------------------- Enumerate
+
+TEST(Enumerate, ShortlexOrder) {
+  // Words ending with ab
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.addState(1);
+  fa.addState(2);
+  fa.setStateInitial(0);
+  fa.setStateFinal(2);
+  fa.addTransition(0,'a',0);
+  fa.addTransition(0,'b',0);
+  fa.addTransition(0,'a',1);
+  fa.addTransition(1,'b',2);
+
+  std::vector<std::string> words;
+  fa.enumerate(4, [&](const std::string& word){
+    words.push_back(word);
+    return true;
+  });
+  std::vector<std::string> expected = {"ab", "aab", "bab", "aaab", "abab", "baab", "bbab"};
+  EXPECT_EQ(expected, words);
+}
+
+TEST(Enumerate, EmptyWordAndStop) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addState(0);
+  fa.setStateInitial(0);
+  fa.setStateFinal(0);
+  fa.addTransition(0,'a',0);
+
+  std::vector<std::string> words;
+  fa.enumerate(100, [&](const std::string& word){
+    words.push_back(word);
+    return words.size() < 3;
+  });
+  std::vector<std::string> expected = {"", "a", "aa"};
+  EXPECT_EQ(expected, words);
+}
+
+TEST(Enumerate, EmptyLanguage) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+
+  std::size_t count = 0;
+  fa.enumerate(5, [&](const std::string&){
+    count++;
+    return true;
+  });
+  EXPECT_EQ(0u, count);
+}
+
+// -------------------------------------------------------------------- WordSampler
+
+TEST(WordSampler, WordsAreAccepted) {
+  // Words ending with ab
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.addState(1);
+  fa.addState(2);
+  fa.setStateInitial(0);
+  fa.setStateFinal(2);
+  fa.addTransition(0,'a',0);
+  fa.addTransition(0,'b',0);
+  fa.addTransition(0,'a',1);
+  fa.addTransition(1,'b',2);
+
+  fa::WordSampler sampler(fa, 10, 42);
+  EXPECT_EQ(fa.countWords(10), sampler.countWords(10));
+  std::string word;
+  for(int i = 0; i < 100; i++){
+    EXPECT_TRUE(sampler.sample(10, word));
+    EXPECT_EQ(10u, word.size());
+    EXPECT_TRUE(fa.match(word));
+  }
+  EXPECT_FALSE(sampler.sample(1, word));
+  EXPECT_EQ(0u, sampler.countWords(11));
+  EXPECT_FALSE(sampler.sample(11, word));
+}
+
+TEST(WordSampler, Uniform) {
+  // a*b* : 4 words of length 3
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateFinal(0);
+  fa.setStateFinal(1);
+  fa.addTransition(0,'a',0);
+  fa.addTransition(0,'b',1);
+  fa.addTransition(1,'b',1);
+
+  fa::WordSampler sampler(fa, 3, 7);
+  std::map<std::string, int> drawn;
+  std::string word;
+  for(int i = 0; i < 4000; i++){
+    sampler.sample(3, word);
+    drawn[word]++;
+  }
+  EXPECT_EQ(4u, drawn.size());
+  for(auto const &count : drawn){
+    EXPECT_GT(count.second, 800);
+    EXPECT_LT(count.second, 1200);
+  }
+}
+
+TEST(WordSampler, Reproducible) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.setStateInitial(0);
+  fa.setStateFinal(0);
+  fa.addTransition(0,'a',0);
+  fa.addTransition(0,'b',0);
+
+  fa::WordSampler first(fa, 20, 1234);
+  fa::WordSampler second(fa, 20, 1234);
+  std::string lhs;
+  std::string rhs;
+  for(int i = 0; i < 10; i++){
+    first.sample(20, lhs);
+    second.sample(20, rhs);
+    EXPECT_EQ(lhs, rhs);
+  }
+  first.seed(1234);
+  second.seed(1234);
+  first.sample(20, lhs);
+  second.sample(20, rhs);
+  EXPECT_EQ(lhs, rhs);
+}
+
+// -------------------------------------------------------------------- Limits
+
+// Words whose n-th letter from the end is a : the deterministic automaton has 2^n states
+static fa::Automaton createNthFromEnd(int n) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  for(int i = 0; i <= n; i++){
+    fa.addState(i);
+  }
+  fa.setStateInitial(0);
+  fa.setStateFinal(n);
+  fa.addTransition(0,'a',0);
+  fa.addTransition(0,'b',0);
+  fa.addTransition(0,'a',1);
+  for(int i = 1; i < n; i++){
+    fa.addTransition(i,'a',i+1);
+    fa.addTransition(i,'b',i+1);
+  }
+  return fa;
+}
+
+TEST(Limits, NoLimit) {
+  fa::Automaton fa = createNthFromEnd(6);
+  fa::Automaton deterministic = fa::Automaton::createDeterministic(fa, fa::Limits());
+  EXPECT_EQ(64u, deterministic.countStates());
+}
+
+TEST(Limits, MaxStates) {
+  fa::Automaton fa = createNthFromEnd(10);
+  fa::Limits limits;
+  limits.maxStates = 100;
+  try{
+    fa::Automaton::createDeterministic(fa, limits);
+    FAIL();
+  }catch(const fa::LimitExceeded& error){
+    EXPECT_EQ(fa::LimitExceeded::Reason::States, error.reason());
+    EXPECT_EQ(101u, error.states());
+  }
+  EXPECT_THROW(fa::Automaton::createMinimalMoore(fa, limits), fa::LimitExceeded);
+  EXPECT_THROW(fa::Automaton::createComplement(fa, limits), fa::LimitExceeded);
+
+  limits.maxStates = 1024;
+  EXPECT_EQ(1024u, fa::Automaton::createDeterministic(fa, limits).countStates());
+}
+
+TEST(Limits, MaxBytes) {
+  fa::Automaton fa = createNthFromEnd(10);
+  fa::Limits limits;
+  limits.maxBytes = 10000;
+  try{
+    fa::Automaton::createDeterministic(fa, limits);
+    FAIL();
+  }catch(const fa::LimitExceeded& error){
+    EXPECT_EQ(fa::LimitExceeded::Reason::Bytes, error.reason());
+  }
+}
+
+TEST(Limits, CancelledAndDeadline) {
+  fa::Automaton fa = createNthFromEnd(10);
+
+  std::atomic<bool> cancelled(true);
+  fa::Limits cancelledLimits;
+  cancelledLimits.cancelled = &cancelled;
+  try{
+    fa::Automaton::createDeterministic(fa, cancelledLimits);
+    FAIL();
+  }catch(const fa::LimitExceeded& error){
+    EXPECT_EQ(fa::LimitExceeded::Reason::Cancelled, error.reason());
+  }
+
+  fa::Limits deadlineLimits;
+  deadlineLimits.deadline = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+  try{
+    fa::Automaton::createProduct({fa::Automaton::createDeterministic(fa), fa}, false, deadlineLimits);
+    FAIL();
+  }catch(const fa::LimitExceeded& error){
+    EXPECT_EQ(fa::LimitExceeded::Reason::Deadline, error.reason());
+  }
+}
+
+TEST(Limits, Progress) {
+  fa::Automaton fa = createNthFromEnd(10);
+  std::size_t reported = 0;
+  fa::Limits limits;
+  limits.progress = [&](std::size_t states){
+    EXPECT_GT(states, reported);
+    reported = states;
+  };
+  fa::Automaton::createDeterministic(fa, limits);
+  EXPECT_EQ(1024u, reported);
+}
+
+TEST(Limits, EstimateDeterministicStates) {
+  fa::Automaton fa = createNthFromEnd(8);
+  std::size_t estimate = fa::Automaton::estimateDeterministicStates(fa);
+  EXPECT_GE(estimate, 256u);
+  EXPECT_LE(estimate, 512u);
+
+  fa::Automaton deterministic = fa::Automaton::createDeterministic(fa);
+  EXPECT_EQ(256u, fa::Automaton::estimateDeterministicStates(deterministic));
+
+  EXPECT_EQ(std::numeric_limits<std::size_t>::max(), fa::Automaton::estimateDeterministicStates(createNthFromEnd(70)));
+}
+
+// -------------------------------------------------------------------- CreateDeterministicParallel
+
+TEST(CreateDeterministicParallel, SameAsSequential) {
+  fa::Automaton fa = createNthFromEnd(8);
+  fa::Automaton sequential = fa::Automaton::createDeterministic(fa);
+  fa::Automaton parallel = fa::Automaton::createDeterministicParallel(fa, 4);
+  EXPECT_EQ(256u, parallel.countStates());
+  EXPECT_EQ(sequential.countTransitions(), parallel.countTransitions());
+  EXPECT_TRUE(parallel.isDeterministic());
+
+  std::ostringstream sequentialPrint;
+  std::ostringstream parallelPrint;
+  sequential.prettyPrint(sequentialPrint);
+  parallel.prettyPrint(parallelPrint);
+  EXPECT_EQ(sequentialPrint.str(), parallelPrint.str());
+}
+
+TEST(CreateDeterministicParallel, IncompleteAutomaton) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.addState(1);
+  fa.addState(2);
+  fa.setStateInitial(0);
+  fa.setStateInitial(1);
+  fa.setStateFinal(2);
+  fa.addTransition(0,'a',2);
+  fa.addTransition(1,'a',1);
+  fa.addTransition(1,'b',2);
+
+  fa::Automaton parallel = fa::Automaton::createDeterministicParallel(fa, 3);
+  EXPECT_TRUE(parallel.isDeterministic());
+  EXPECT_TRUE(parallel.isEquivalentTo(fa));
+  EXPECT_TRUE(parallel.match("a"));
+  EXPECT_TRUE(parallel.match("b"));
+  EXPECT_TRUE(parallel.match("aab"));
+  EXPECT_FALSE(parallel.match("aa"));
+  EXPECT_FALSE(parallel.match("ba"));
+}
+
+TEST(CreateDeterministicParallel, Limits) {
+  fa::Automaton fa = createNthFromEnd(12);
+  fa::Limits limits;
+  limits.maxStates = 1000;
+  try{
+    fa::Automaton::createDeterministicParallel(fa, 4, limits);
+    FAIL();
+  }catch(const fa::LimitExceeded& error){
+    EXPECT_EQ(fa::LimitExceeded::Reason::States, error.reason());
+  }
+}
+
+// -------------------------------------------------------------------- CreateMinimalMooreParallel
+
+TEST(CreateMinimalMooreParallel, SameAsSequential) {
+  fa::Automaton fa = createNthFromEnd(6);
+  fa::Automaton sequential = fa::Automaton::createMinimalMoore(fa);
+  fa::Automaton parallel = fa::Automaton::createMinimalMooreParallel(fa, 4);
+  EXPECT_EQ(64u, parallel.countStates());
+  EXPECT_EQ(128u, parallel.countTransitions());
+
+  std::ostringstream sequentialPrint;
+  std::ostringstream parallelPrint;
+  sequential.prettyPrint(sequentialPrint);
+  parallel.prettyPrint(parallelPrint);
+  EXPECT_EQ(sequentialPrint.str(), parallelPrint.str());
+}
+
+TEST(CreateMinimalMooreParallel, MergesEquivalentStates) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  for(int i = 0; i < 6; i++){
+    fa.addState(i);
+  }
+  fa.setStateInitial(0);
+  fa.setStateFinal(3);
+  fa.setStateFinal(4);
+  fa.addTransition(0,'a',1);
+  fa.addTransition(0,'b',2);
+  fa.addTransition(1,'a',3);
+  fa.addTransition(1,'b',4);
+  fa.addTransition(2,'a',4);
+  fa.addTransition(2,'b',3);
+  fa.addTransition(3,'a',5);
+  fa.addTransition(3,'b',5);
+  fa.addTransition(4,'a',5);
+  fa.addTransition(4,'b',5);
+  fa.addTransition(5,'a',5);
+  fa.addTransition(5,'b',5);
+
+  fa::Automaton minimal = fa::Automaton::createMinimalMooreParallel(fa, 3);
+  EXPECT_EQ(4u, minimal.countStates());
+  EXPECT_EQ(fa::Automaton::createMinimalMoore(fa).countStates(), minimal.countStates());
+  EXPECT_TRUE(minimal.isEquivalentTo(fa));
+  EXPECT_TRUE(minimal.match("ab"));
+  EXPECT_FALSE(minimal.match("abb"));
+}
+
+TEST(CreateMinimalMooreParallel, SingleThread) {
+  fa::Automaton fa = createNthFromEnd(4);
+  fa::Automaton minimal = fa::Automaton::createMinimalMooreParallel(fa, 1);
+  EXPECT_EQ(16u, minimal.countStates());
+  EXPECT_TRUE(minimal.isEquivalentTo(fa));
+}
+
+// -------------------------------------------------------------------- CreateMinimalBrzozowski fused
+
+TEST(CreateMinimalBrzozowskiFused, SameSizeAsMoore) {
+  fa::Automaton fa = createNthFromEnd(7);
+  fa::Automaton brzozowski = fa::Automaton::createMinimalBrzozowski(fa);
+  fa::Automaton moore = fa::Automaton::createMinimalMoore(fa);
+  EXPECT_EQ(moore.countStates(), brzozowski.countStates());
+  EXPECT_EQ(moore.countTransitions(), brzozowski.countTransitions());
+  EXPECT_TRUE(brzozowski.isDeterministic());
+  EXPECT_TRUE(brzozowski.isComplete());
+  EXPECT_TRUE(brzozowski.isEquivalentTo(fa));
+}
+
+TEST(CreateMinimalBrzozowskiFused, DeterministicWithUselessStates) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.addState(1);
+  fa.addState(2);
+  fa.addState(3);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  fa.setStateFinal(3);
+  fa.addTransition(0,'a',1);
+  fa.addTransition(1,'a',1);
+  fa.addTransition(2,'b',3);
+
+  fa::Automaton minimal = fa::Automaton::createMinimalBrzozowski(fa);
+  EXPECT_EQ(3u, minimal.countStates());
+  EXPECT_TRUE(minimal.isEquivalentTo(fa));
+}
+
+TEST(CreateMinimalBrzozowskiFused, EmptyLanguage) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.addTransition(0,'a',1);
+
+  fa::Automaton minimal = fa::Automaton::createMinimalBrzozowski(fa);
+  EXPECT_EQ(1u, minimal.countStates());
+  EXPECT_TRUE(minimal.isLanguageEmpty());
+}
+
+// -------------------------------------------------------------------- Canonicalize
+
+TEST(Canonicalize, SameLanguageSameForm) {
+  // Words ending with ab
+  fa::Automaton nondeterministic;
+  nondeterministic.addSymbol('a');
+  nondeterministic.addSymbol('b');
+  nondeterministic.addState(0);
+  nondeterministic.addState(1);
+  nondeterministic.addState(2);
+  nondeterministic.setStateInitial(0);
+  nondeterministic.setStateFinal(2);
+  nondeterministic.addTransition(0,'a',0);
+  nondeterministic.addTransition(0,'b',0);
+  nondeterministic.addTransition(0,'a',1);
+  nondeterministic.addTransition(1,'b',2);
+
+  // The same language, with other numbers and a useless state
+  fa::Automaton deterministic;
+  deterministic.addSymbol('a');
+  deterministic.addSymbol('b');
+  deterministic.addState(10);
+  deterministic.addState(20);
+  deterministic.addState(30);
+  deterministic.addState(40);
+  deterministic.setStateInitial(30);
+  deterministic.setStateFinal(10);
+  deterministic.addTransition(30,'a',20);
+  deterministic.addTransition(30,'b',30);
+  deterministic.addTransition(20,'a',20);
+  deterministic.addTransition(20,'b',10);
+  deterministic.addTransition(10,'a',20);
+  deterministic.addTransition(10,'b',30);
+  deterministic.addTransition(40,'a',10);
+
+  nondeterministic.canonicalize();
+  deterministic.canonicalize();
+  EXPECT_EQ(3u, deterministic.countStates());
+  EXPECT_TRUE(deterministic.isStateInitial(0));
+  EXPECT_TRUE(deterministic.hasTransition(0,'a',1));
+  EXPECT_TRUE(deterministic.hasTransition(0,'b',0));
+  EXPECT_TRUE(deterministic.hasTransition(1,'b',2));
+  EXPECT_TRUE(deterministic.isStateFinal(2));
+
+  std::ostringstream lhs;
+  std::ostringstream rhs;
+  nondeterministic.prettyPrint(lhs);
+  deterministic.prettyPrint(rhs);
+  EXPECT_EQ(lhs.str(), rhs.str());
+}
+
+TEST(Canonicalize, LanguageHash) {
+  fa::Automaton fa = createNthFromEnd(3);
+  fa::Automaton minimal = fa::Automaton::createMinimalMoore(fa);
+  EXPECT_EQ(fa.languageHash(), minimal.languageHash());
+  EXPECT_EQ(fa.languageHash(), fa::Automaton::createCanonical(fa).languageHash());
+
+  fa::Automaton other = createNthFromEnd(4);
+  EXPECT_NE(fa.languageHash(), other.languageHash());
+
+  fa::Automaton complement = fa::Automaton::createComplement(fa);
+  EXPECT_NE(fa.languageHash(), complement.languageHash());
+}
+
+TEST(Canonicalize, AlphabetMatters) {
+  fa::Automaton lhs;
+  lhs.addSymbol('a');
+  lhs.addState(0);
+  lhs.setStateInitial(0);
+  lhs.setStateFinal(0);
+  lhs.addTransition(0,'a',0);
+
+  fa::Automaton rhs = lhs;
+  rhs.addSymbol('b');
+  EXPECT_NE(lhs.languageHash(), rhs.languageHash());
+}
+
+// -------------------------------------------------------------------- OperationCache
+
+TEST(OperationCache, NotInstalledByDefault) {
+  EXPECT_EQ(nullptr, fa::OperationCache::installed());
+}
+
+TEST(OperationCache, ComplementIsReused) {
+  fa::OperationCache cache(1 << 20);
+  fa::OperationCache::install(&cache);
+
+  fa::Automaton fa = createNthFromEnd(4);
+  fa::Automaton first = fa::Automaton::createComplement(fa);
+  EXPECT_EQ(0u, cache.countHits());
+  fa::Automaton second = fa::Automaton::createComplement(fa);
+  EXPECT_EQ(1u, cache.countHits());
+  EXPECT_EQ(first.countStates(), second.countStates());
+  EXPECT_EQ(first.countTransitions(), second.countTransitions());
+  EXPECT_TRUE(second.isEquivalentTo(first));
+  EXPECT_GT(cache.countBytes(), 0u);
+
+  fa::OperationCache::install(nullptr);
+}
+
+TEST(OperationCache, HitsKeepTheLimits) {
+  fa::OperationCache cache(1 << 20);
+  fa::OperationCache::install(&cache);
+
+  fa::Automaton fa = createNthFromEnd(4);
+  fa::Automaton deterministic = fa::Automaton::createDeterministic(fa);
+  fa::Automaton complement = fa::Automaton::createComplement(fa);
+  fa::Automaton minimal = fa::Automaton::createMinimalMoore(fa);
+  std::size_t hits = cache.countHits();
+
+  fa::Limits states;
+  states.maxStates = minimal.countStates() - 1;
+  EXPECT_THROW(fa::Automaton::createDeterministic(fa, states), fa::LimitExceeded);
+  EXPECT_THROW(fa::Automaton::createComplement(fa, states), fa::LimitExceeded);
+  EXPECT_THROW(fa::Automaton::createMinimalMoore(fa, states), fa::LimitExceeded);
+
+  fa::Limits bytes;
+  bytes.maxBytes = 1;
+  try{
+    fa::Automaton::createDeterministic(fa, bytes);
+    ADD_FAILURE() << "The limit of the memory is ignored";
+  }catch(const fa::LimitExceeded& error){
+    EXPECT_EQ(fa::LimitExceeded::Reason::Bytes, error.reason());
+  }
+
+  std::atomic<bool> cancelled(true);
+  fa::Limits cancel;
+  cancel.cancelled = &cancelled;
+  try{
+    fa::Automaton::createMinimalMoore(fa, cancel);
+    ADD_FAILURE() << "The cancellation is ignored";
+  }catch(const fa::LimitExceeded& error){
+    EXPECT_EQ(fa::LimitExceeded::Reason::Cancelled, error.reason());
+  }
+
+  fa::Limits deadline;
+  deadline.deadline = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+  EXPECT_THROW(fa::Automaton::createComplement(fa, deadline), fa::LimitExceeded);
+  EXPECT_EQ(hits + 6, cache.countHits());
+
+  fa::Limits enough;
+  enough.maxStates = deterministic.countStates();
+  EXPECT_EQ(deterministic.countStates(), fa::Automaton::createDeterministic(fa, enough).countStates());
+
+  fa::OperationCache::install(nullptr);
+}
+
+TEST(OperationCache, IncludedInSweep) {
+  fa::OperationCache cache(1 << 20);
+  fa::OperationCache::install(&cache);
+
+  fa::Automaton reference = createNthFromEnd(3);
+  std::size_t included = 0;
+  for(int n = 1; n <= 5; n++){
+    fa::Automaton candidate = createNthFromEnd(n);
+    if(candidate.isIncludedIn(reference)){
+      included++;
+    }
+  }
+  EXPECT_EQ(1u, included);
+  EXPECT_GE(cache.countHits(), 4u);
+
+  fa::OperationCache::install(nullptr);
+}
+
+TEST(OperationCache, LeastRecentlyUsedIsEvicted) {
+  fa::Automaton small = createNthFromEnd(2);
+  fa::Automaton other = createNthFromEnd(3);
+
+  fa::OperationCache measure(1 << 20);
+  fa::OperationCache::install(&measure);
+  fa::Automaton::createDeterministic(other);
+  std::size_t otherBytes = measure.countBytes();
+  fa::OperationCache::install(nullptr);
+
+  fa::OperationCache cache(otherBytes + 1);
+  fa::OperationCache::install(&cache);
+  fa::Automaton::createDeterministic(small);
+  EXPECT_EQ(1u, cache.countEntries());
+  fa::Automaton::createDeterministic(other);
+  EXPECT_EQ(1u, cache.countEntries());
+  EXPECT_LE(cache.countBytes(), otherBytes + 1);
+
+  fa::Automaton::createDeterministic(other);
+  EXPECT_EQ(1u, cache.countHits());
+  fa::Automaton::createDeterministic(small);
+  EXPECT_EQ(1u, cache.countHits());
+  EXPECT_EQ(3u, cache.countMisses());
+
+  cache.clear();
+  EXPECT_EQ(0u, cache.countEntries());
+  EXPECT_EQ(0u, cache.countBytes());
+  fa::OperationCache::install(nullptr);
+}
+
+TEST(OperationCache, UninstallWaitsForTransformations) {
+  fa::Automaton fa = createNthFromEnd(10);
+  std::size_t expected = fa::Automaton::createDeterministic(fa).countStates();
+  std::atomic<bool> done(false);
+  std::thread worker([&]{
+    while(!done){
+      EXPECT_EQ(expected, fa::Automaton::createDeterministic(fa).countStates());
+    }
+  });
+  for(int round = 0; round < 50; round++){
+    auto cache = std::make_unique<fa::OperationCache>(1 << 20);
+    fa::OperationCache::install(cache.get());
+    fa::Automaton::createDeterministic(fa);
+    fa::OperationCache::install(nullptr);
+    // No transformation uses the cache anymore, it can be destroyed
+  }
+  done = true;
+  worker.join();
+}
+
+TEST(DenseStates, SparseIds) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  EXPECT_TRUE(fa.addState(1000000000));
+  EXPECT_TRUE(fa.addState(7));
+  EXPECT_TRUE(fa.addState(2147483647));
+  EXPECT_FALSE(fa.addState(1000000000));
+  fa.setStateInitial(1000000000);
+  fa.setStateFinal(2147483647);
+  EXPECT_TRUE(fa.addTransition(1000000000, 'a', 7));
+  EXPECT_TRUE(fa.addTransition(7, 'b', 2147483647));
+  EXPECT_FALSE(fa.addTransition(7, 'b', 2147483647));
+  EXPECT_FALSE(fa.hasState(8));
+
+  EXPECT_EQ(3u, fa.countStates());
+  EXPECT_EQ(2u, fa.countTransitions());
+  EXPECT_TRUE(fa.match("ab"));
+  EXPECT_FALSE(fa.match("a"));
+  std::set<int> ends = fa.readString("ab");
+  EXPECT_EQ(1u, ends.size());
+  EXPECT_EQ(1u, ends.count(2147483647));
+
+  fa::Automaton minimal = fa::Automaton::createMinimalMoore(fa);
+  EXPECT_TRUE(minimal.isEquivalentTo(fa));
+  EXPECT_EQ(4u, minimal.countStates());
+}
+
+TEST(DenseStates, RemoveStateKeepsOthers) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  for(int state = 10; state < 60; state += 10){
+    fa.addState(state);
+  }
+  fa.setStateInitial(10);
+  fa.setStateFinal(50);
+  fa.addTransition(10, 'a', 20);
+  fa.addTransition(20, 'a', 30);
+  fa.addTransition(30, 'a', 40);
+  fa.addTransition(40, 'a', 50);
+  fa.addTransition(10, 'a', 50);
+  fa.addTransition(50, 'a', 20);
+
+  EXPECT_TRUE(fa.removeState(30));
+  EXPECT_FALSE(fa.removeState(30));
+  EXPECT_EQ(4u, fa.countStates());
+  EXPECT_EQ(4u, fa.countTransitions());
+  EXPECT_FALSE(fa.hasState(30));
+  EXPECT_TRUE(fa.hasTransition(40, 'a', 50));
+  EXPECT_TRUE(fa.hasTransition(10, 'a', 50));
+  EXPECT_TRUE(fa.hasTransition(50, 'a', 20));
+  EXPECT_FALSE(fa.hasTransition(20, 'a', 30));
+  EXPECT_TRUE(fa.isStateInitial(10));
+  EXPECT_TRUE(fa.isStateFinal(50));
+  EXPECT_TRUE(fa.match("a"));
+  EXPECT_FALSE(fa.match("aaaa"));
+
+  EXPECT_TRUE(fa.addState(30));
+  EXPECT_FALSE(fa.isStateFinal(30));
+  EXPECT_EQ(0u, fa.readString("aa").count(30));
+}
+
+TEST(DenseStates, RemoveTransitionOnlyFromItsOrigin) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addState(1);
+  fa.addState(2);
+  fa.addState(3);
+  fa.addTransition(2, 'a', 3);
+
+  EXPECT_FALSE(fa.removeTransition(1, 'a', 3));
+  EXPECT_TRUE(fa.hasTransition(2, 'a', 3));
+  EXPECT_TRUE(fa.removeTransition(2, 'a', 3));
+  EXPECT_EQ(0u, fa.countTransitions());
+}
+
+TEST(DenseStates, CompleteWithSparseIds) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(1000000000);
+  fa.addState(2000000000);
+  fa.setStateInitial(1000000000);
+  fa.setStateFinal(2000000000);
+  fa.addTransition(1000000000, 'a', 2000000000);
+
+  fa::Automaton complete = fa::Automaton::createComplete(fa);
+  EXPECT_TRUE(complete.isComplete());
+  EXPECT_EQ(3u, complete.countStates());
+  EXPECT_TRUE(complete.hasState(0));
+  EXPECT_TRUE(complete.hasTransition(1000000000, 'b', 0));
+  EXPECT_TRUE(complete.isEquivalentTo(fa));
+}
+
+TEST(DenseStates, CompleteSinkInGap) {
+  // The sink takes the first number that no state uses, even next to the greatest int
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.addState(1);
+  fa.addState(3);
+  fa.addState(std::numeric_limits<int>::max());
+  fa.setStateInitial(0);
+  fa.setStateFinal(std::numeric_limits<int>::max());
+  fa.addTransition(0, 'a', std::numeric_limits<int>::max());
+  fa.addTransition(0, 'b', 1);
+  fa.addTransition(1, 'a', 3);
+  fa.addTransition(3, 'a', 0);
+
+  fa::Automaton complete = fa::Automaton::createComplete(fa);
+  EXPECT_TRUE(complete.isComplete());
+  EXPECT_EQ(5u, complete.countStates());
+  EXPECT_TRUE(complete.hasTransition(std::numeric_limits<int>::max(), 'a', 2));
+  EXPECT_TRUE(complete.isEquivalentTo(fa));
+}
+
+TEST(DenseStates, LongChain) {
+  const int length = 200000;
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  for(int state = 0; state <= length; state++){
+    fa.addState(state * 5000);
+  }
+  fa.setStateInitial(0);
+  fa.setStateFinal(length * 5000);
+  for(int state = 0; state < length; state++){
+    fa.addTransition(state * 5000, 'a', (state + 1) * 5000);
+  }
+
+  EXPECT_FALSE(fa.isLanguageEmpty());
+  EXPECT_TRUE(fa.match(std::string(length, 'a')));
+  fa.removeNonCoAccessibleStates();
+  EXPECT_EQ((std::size_t)length + 1, fa.countStates());
+  fa.removeState(length * 5000);
+  fa.removeNonCoAccessibleStates();
+  EXPECT_EQ(1u, fa.countStates());
+}
+
+TEST(StateFlags, FlagsFollowRemovedStates) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  for(int state = 0; state < 150; state++){
+    fa.addState(state);
+    if(state % 3 == 0){
+      fa.setStateInitial(state);
+    }
+    if(state % 5 == 0){
+      fa.setStateFinal(state);
+    }
+  }
+  for(int state = 0; state < 150; state += 2){
+    fa.removeState(state);
+  }
+  EXPECT_EQ(75u, fa.countStates());
+  for(int state = 1; state < 150; state += 2){
+    EXPECT_EQ(state % 3 == 0, fa.isStateInitial(state));
+    EXPECT_EQ(state % 5 == 0, fa.isStateFinal(state));
+  }
+  EXPECT_FALSE(fa.isStateInitial(0));
+  EXPECT_FALSE(fa.isLanguageEmpty());
+  EXPECT_TRUE(fa.match(""));
+
+  std::set<int> initials = fa.readString("");
+  EXPECT_EQ(25u, initials.size());
+  EXPECT_EQ(3, *initials.begin());
+  EXPECT_EQ(147, *initials.rbegin());
+}
+
+TEST(StateFlags, ManyInitialStates) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(1000);
+  fa.setStateFinal(1000);
+  for(int state = 0; state < 100; state++){
+    fa.addState(state);
+    fa.setStateInitial(state);
+    fa.addTransition(state, state % 2 == 0 ? 'a' : 'b', 1000);
+  }
+  EXPECT_FALSE(fa.isDeterministic());
+  EXPECT_TRUE(fa.match("a"));
+  EXPECT_TRUE(fa.match("b"));
+  EXPECT_FALSE(fa.match("ab"));
+  EXPECT_EQ(100u, fa.readString("").size());
+  EXPECT_EQ(1u, fa.readString("b").size());
+
+  fa::Automaton deterministic = fa::Automaton::createDeterministic(fa);
+  EXPECT_TRUE(deterministic.isDeterministic());
+  EXPECT_TRUE(deterministic.isEquivalentTo(fa));
+}
+
+TEST(StateFlags, ComplementFlipsEveryState) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addState(0);
+  for(int state = 1; state < 70; state++){
+    fa.addState(state);
+    fa.addTransition(state - 1, 'a', state);
+  }
+  fa.setStateInitial(0);
+  fa.setStateFinal(69);
+
+  fa::Automaton complement = fa::Automaton::createComplement(fa);
+  EXPECT_TRUE(complement.match(""));
+  EXPECT_TRUE(complement.match(std::string(68, 'a')));
+  EXPECT_FALSE(complement.match(std::string(69, 'a')));
+  EXPECT_TRUE(complement.match(std::string(70, 'a')));
+  EXPECT_TRUE(complement.hasEmptyIntersectionWith(fa));
+  EXPECT_TRUE(fa::Automaton::createComplement(complement).isEquivalentTo(fa));
+}
+
+static fa::Automaton createRandomAutomaton(int states, unsigned seed, const char* letters = "abc") {
+  std::mt19937 generator(seed);
+  fa::Automaton fa;
+  for(int letter = 0; letter < 3; letter++){
+    fa.addSymbol(letters[letter]);
+  }
+  for(int state = 0; state < states; state++){
+    fa.addState(state * 7);
+    if(generator() % 8 == 0){
+      fa.setStateInitial(state * 7);
+    }
+    if(generator() % 4 == 0){
+      fa.setStateFinal(state * 7);
+    }
+  }
+  fa.setStateInitial(0);
+  for(int transition = 0; transition < 3 * states; transition++){
+    fa.addTransition((int)(generator() % states) * 7, letters[generator() % 3], (int)(generator() % states) * 7);
+  }
+  return fa;
+}
+
+static bool matchBySets(const fa::Automaton& fa, const std::string& word) {
+  for(auto state : fa.readString(word)){
+    if(fa.isStateFinal(state)){
+      return true;
+    }
+  }
+  return false;
+}
+
+TEST(BitParallelMatcher, SameAnswersAsReadString) {
+  for(int states : {1, 5, 63, 64, 65, 128, 129, 200, 256}){
+    fa::Automaton fa = createRandomAutomaton(states, states);
+    ASSERT_TRUE(fa::BitParallelMatcher::fits(fa));
+    fa::BitParallelMatcher matcher(fa);
+    EXPECT_EQ((std::size_t)states, matcher.countStates());
+
+    std::mt19937 generator(states);
+    for(int test = 0; test < 200; test++){
+      std::string word;
+      for(int letter = generator() % 12; letter > 0; letter--){
+        word.push_back("abc"[generator() % 3]);
+      }
+      bool expected = matchBySets(fa, word);
+      EXPECT_EQ(expected, matcher.match(word)) << states << " " << word;
+      EXPECT_EQ(expected, fa.match(word)) << states << " " << word;
+    }
+  }
+}
+
+TEST(BitParallelMatcher, TooManyStates) {
+  fa::Automaton fa = createRandomAutomaton(257, 1);
+  EXPECT_FALSE(fa::BitParallelMatcher::fits(fa));
+  EXPECT_THROW(fa::BitParallelMatcher matcher(fa), std::invalid_argument);
+  std::mt19937 generator(2);
+  for(int test = 0; test < 50; test++){
+    std::string word;
+    for(int letter = generator() % 8; letter > 0; letter--){
+      word.push_back("abc"[generator() % 3]);
+    }
+    EXPECT_EQ(matchBySets(fa, word), fa.match(word));
+  }
+}
+
+TEST(BitParallelMatcher, UnknownLetter) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateFinal(0);
+  fa.addTransition(0, 'a', 1);
+  fa.addTransition(1, 'a', 0);
+
+  fa::BitParallelMatcher matcher(fa);
+  EXPECT_TRUE(matcher.match(""));
+  EXPECT_TRUE(matcher.match("aa"));
+  EXPECT_FALSE(matcher.match("a"));
+  EXPECT_FALSE(matcher.match("ab"));
+  EXPECT_FALSE(matcher.match("ax"));
+  EXPECT_FALSE(fa.match("aab"));
+}
+
+TEST(DfaMatcher, SameAnswersAsMatch) {
+  fa::Automaton fa = createRandomAutomaton(12, 3);
+  fa::DfaMatcher matcher(fa);
+  std::mt19937 generator(4);
+  for(int test = 0; test < 300; test++){
+    std::string word;
+    for(int letter = generator() % 10; letter > 0; letter--){
+      word.push_back("abcd"[generator() % 4]);
+    }
+    EXPECT_EQ(fa.match(word), matcher.match(word)) << word;
+  }
+}
+
+TEST(DfaMatcher, EveryKernelGivesTheSameAnswers) {
+  fa::Automaton fa = createNthFromEnd(4);
+  fa::DfaMatcher matcher(fa);
+  EXPECT_TRUE(fa::DfaMatcher::supports(fa::DfaMatcher::Kernel::Scalar));
+
+  std::mt19937 generator(5);
+  std::vector<std::string> words;
+  for(int test = 0; test < 1001; test++){
+    std::string word;
+    for(int letter = generator() % (test % 50 == 0 ? 40 : 9); letter > 0; letter--){
+      word.push_back("abx"[generator() % 3]);
+    }
+    words.push_back(word);
+  }
+
+  for(auto kernel : {fa::DfaMatcher::Kernel::Automatic, fa::DfaMatcher::Kernel::Scalar, fa::DfaMatcher::Kernel::Avx2, fa::DfaMatcher::Kernel::Avx512}){
+    std::vector<bool> accepted;
+    matcher.matchMany(words, accepted, kernel);
+    ASSERT_EQ(words.size(), accepted.size());
+    for(std::size_t word = 0; word < words.size(); word++){
+      EXPECT_EQ(fa.match(words[word]), accepted[word]) << words[word];
+    }
+  }
+}
+
+TEST(DfaMatcher, FewWords) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  fa.addTransition(0, 'a', 1);
+
+  fa::DfaMatcher matcher(fa);
+  EXPECT_EQ(3u, matcher.countStates());
+  std::vector<bool> accepted(5, true);
+  matcher.matchMany({}, accepted);
+  EXPECT_TRUE(accepted.empty());
+  matcher.matchMany({"a", "", "aa"}, accepted);
+  EXPECT_EQ((std::vector<bool>{true, false, false}), accepted);
+}
+
+TEST(DfaMatcher, Limits) {
+  fa::Limits limits;
+  limits.maxStates = 10;
+  EXPECT_THROW(fa::DfaMatcher(createNthFromEnd(8), limits), fa::LimitExceeded);
+}
+
+static fa::Automaton createPrintExample() {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  fa.addState(2);
+  fa.addState(1);
+  fa.addState(3);
+  fa.setStateInitial(1);
+  fa.setStateFinal(2);
+  fa.addTransition(1, 'b', 2);
+  fa.addTransition(1, 'a', 2);
+  fa.addTransition(2, 'a', 1);
+  return fa;
+}
+
+TEST(Print, PrettyPrint) {
+  std::ostringstream out;
+  createPrintExample().prettyPrint(out);
+  EXPECT_EQ("Initial states :\n\t 1\nFinal states :\n\t 2\nTransitions :\n"
+    "\t For state 1 : \n\t\t For letter a : 2 \n\n\t\t For letter b : 2 \n\n"
+    "\t For state 2 : \n\t\t For letter a : 1 \n\n\t\t For letter b : \n\n"
+    "\t For state 3 : \n\t\t For letter a : \n\n\t\t For letter b : \n\n", out.str());
+}
+
+TEST(Print, DotPrintMergesParallelEdges) {
+  std::ostringstream out;
+  createPrintExample().dotPrint(out);
+  EXPECT_EQ("digraph Automaton {\n  rankdir=LR;\n  node [shape=circle];\n"
+    "  start1 [shape=point];\n  start1 -> 1;\n  2 [shape=doublecircle];\n  3;\n"
+    "  1 -> 2 [label=\"a,b\"];\n  2 -> 1 [label=\"a\"];\n}\n", out.str());
+}
+
+TEST(Print, DotPrintWithoutMerge) {
+  fa::PrintOptions options;
+  options.mergeParallelEdges = false;
+  std::ostringstream out;
+  createPrintExample().dotPrint(out, options);
+  std::string dot = out.str();
+  EXPECT_NE(std::string::npos, dot.find("  1 -> 2 [label=\"b\"];\n  1 -> 2 [label=\"a\"];\n"));
+  EXPECT_EQ(std::string::npos, dot.find("a,b"));
+}
+
+TEST(Print, HugeAutomatonIsTruncated) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addSymbol('b');
+  for(int state = 0; state < 100000; state++){
+    fa.addState(state);
+  }
+  fa.setStateInitial(0);
+  fa.setStateFinal(99999);
+  for(int state = 0; state + 1 < 100000; state++){
+    fa.addTransition(state, 'a', state + 1);
+    fa.addTransition(state, 'b', state + 1);
+  }
+
+  std::ostringstream full;
+  fa.dotPrint(full);
+  EXPECT_NE(std::string::npos, full.str().find("  99998 -> 99999 [label=\"a,b\"];\n}\n"));
+
+  fa::PrintOptions options;
+  options.maxBytes = 10000;
+  std::ostringstream dot;
+  fa.dotPrint(dot, options);
+  EXPECT_LT(dot.str().size(), 10200u);
+  EXPECT_NE(std::string::npos, dot.str().find("// truncated\n}\n"));
+
+  std::ostringstream pretty;
+  fa.prettyPrint(pretty, options);
+  EXPECT_LT(pretty.str().size(), 10200u);
+  EXPECT_EQ("...\n", pretty.str().substr(pretty.str().size() - 4));
+}
+
+TEST(Parse, Ba) {
+  fa::Automaton fa = fa::Automaton::parse("[1]\na,[1]->[2]\nb,[2]->[1]\n\na,[1]->[2]\r\n[2]\n", fa::Format::Ba);
+  EXPECT_EQ(2u, fa.countStates());
+  EXPECT_EQ(2u, fa.countSymbols());
+  EXPECT_EQ(2u, fa.countTransitions());
+  EXPECT_TRUE(fa.isStateInitial(1));
+  EXPECT_FALSE(fa.isStateInitial(2));
+  EXPECT_TRUE(fa.isStateFinal(2));
+  EXPECT_TRUE(fa.match("aba"));
+  EXPECT_FALSE(fa.match("ab"));
+}
+
+TEST(Parse, BaWithoutInitialLine) {
+  fa::Automaton fa = fa::Automaton::parse("a,[5]->[5]\nb,[5]->[9]\n[9]\n", fa::Format::Ba);
+  EXPECT_TRUE(fa.isStateInitial(5));
+  EXPECT_TRUE(fa.match("aab"));
+}
+
+TEST(Parse, Att) {
+  std::istringstream in("0 1 a\n1 1 b 0.5\n1 2 <eps>\n1\n2 0.25\n");
+  fa::Automaton fa = fa::Automaton::parse(in, fa::Format::Att);
+  EXPECT_EQ(3u, fa.countStates());
+  EXPECT_EQ(2u, fa.countSymbols());
+  EXPECT_TRUE(fa.hasEpsilonTransition());
+  EXPECT_TRUE(fa.isStateInitial(0));
+  EXPECT_TRUE(fa.isStateFinal(1));
+  EXPECT_TRUE(fa.isStateFinal(2));
+  EXPECT_TRUE(fa.match("abb"));
+}
+
+TEST(Parse, Errors) {
+  auto lineOf = [](const std::string& text, fa::Format format){
+    try{
+      fa::Automaton::parse(text, format);
+    }catch(const fa::ParseError& error){
+      return error.line();
+    }
+    return (std::size_t)0;
+  };
+  EXPECT_EQ(3u, lineOf("[0]\na,[0]->[1]\na,[0]-[1]\n", fa::Format::Ba));
+  EXPECT_EQ(2u, lineOf("[0]\na,[x]->[1]\n", fa::Format::Ba));
+  EXPECT_EQ(4u, lineOf("[0]\na,[0]->[1]\n[1]\na,[1]->[0]\n", fa::Format::Ba));
+  EXPECT_EQ(1u, lineOf("[99999999999]\n", fa::Format::Ba));
+  EXPECT_EQ(2u, lineOf("0 1 a\n0 x a\n", fa::Format::Att));
+  EXPECT_EQ(2u, lineOf("0 1 a\n\n1 2 ab\n", fa::Format::Att) - 1);
+  EXPECT_EQ(1u, lineOf("0 1 a 1 2\n", fa::Format::Att));
+  EXPECT_THROW(fa::Automaton::parse("-1 2 a\n", fa::Format::Att), fa::ParseError);
+}
+
+TEST(Parse, WriteThenParse) {
+  fa::Automaton nondeterministic = createNthFromEnd(4);
+  fa::Automaton deterministic = fa::Automaton::createDeterministic(nondeterministic);
+  for(auto const &fa : {nondeterministic, deterministic}){
+    for(auto format : {fa::Format::Ba, fa::Format::Att}){
+      std::ostringstream out;
+      ASSERT_TRUE(fa.write(out, format));
+      fa::Automaton parsed = fa::Automaton::parse(out.str(), format);
+      EXPECT_TRUE(parsed.isEquivalentTo(fa));
+      EXPECT_EQ(fa.countStates(), parsed.countStates());
+      EXPECT_EQ(fa.countTransitions(), parsed.countTransitions());
+      std::ostringstream again;
+      ASSERT_TRUE(parsed.write(again, format));
+      fa::Automaton reparsed = fa::Automaton::parse(again.str(), format);
+      EXPECT_TRUE(reparsed.isEquivalentTo(fa));
+    }
+  }
+}
+
+TEST(Parse, CannotWrite) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addState(0);
+  fa.addState(1);
+  std::ostringstream out;
+  EXPECT_FALSE(fa.write(out, fa::Format::Ba));
+  fa.setStateInitial(0);
+  fa.setStateFinal(0);
+  EXPECT_FALSE(fa.write(out, fa::Format::Ba));
+  EXPECT_TRUE(out.str().empty());
+  fa.addTransition(0, 'a', 0);
+  EXPECT_TRUE(fa.write(out, fa::Format::Ba));
+  EXPECT_EQ("[0]\na,[0]->[0]\n[0]\n", out.str());
+  fa.removeTransition(0, 'a', 0);
+  EXPECT_FALSE(fa.write(out, fa::Format::Att));
+  fa.addTransition(0, 'a', 0);
+  fa.addTransition(0, fa::Epsilon, 1);
+  EXPECT_FALSE(fa.write(out, fa::Format::Ba));
+  EXPECT_TRUE(fa.write(out, fa::Format::Att));
+}
+
+TEST(Parse, ManyLines) {
+  std::string text;
+  for(int state = 0; state < 200000; state++){
+    text += std::to_string(state) + " " + std::to_string(state + 1) + " " + "ab"[state % 2] + "\n";
+  }
+  text += "200000\n";
+  fa::Automaton fa = fa::Automaton::parse(text, fa::Format::Att);
+  EXPECT_EQ(200001u, fa.countStates());
+  EXPECT_EQ(200000u, fa.countTransitions());
+  std::string word;
+  for(int state = 0; state < 200000; state++){
+    word.push_back("ab"[state % 2]);
+  }
+  EXPECT_TRUE(fa.match(word));
+  std::istringstream in(text);
+  fa::Automaton streamed = fa::Automaton::parse(in, fa::Format::Att);
+  EXPECT_EQ(200001u, streamed.countStates());
+  EXPECT_EQ(200000u, streamed.countTransitions());
+  EXPECT_TRUE(streamed.match(word));
+  std::istringstream wrong(text + "1 2 ab\n");
+  try{
+    fa::Automaton::parse(wrong, fa::Format::Att);
+    FAIL();
+  }catch(const fa::ParseError& error){
+    EXPECT_EQ(200002u, error.line());
+  }
+}
+
+TEST(Parse, RandomRoundTrip) {
+  for(unsigned seed = 1; seed <= 20; seed++){
+    // The letters of the Ba format, like '[' and ',', are also drawn
+    fa::Automaton fa = fa::Automaton::createDeterministic(createRandomAutomaton(30, seed, seed % 2 == 0 ? "abc" : "[,]"));
+    fa.addSymbol('d');
+    for(auto format : {fa::Format::Ba, fa::Format::Att}){
+      std::ostringstream out;
+      EXPECT_FALSE(fa.write(out, format));
+    }
+    fa.removeSymbol('d');
+    for(auto format : {fa::Format::Ba, fa::Format::Att}){
+      std::ostringstream out;
+      ASSERT_TRUE(fa.write(out, format));
+      std::istringstream in(out.str());
+      fa::Automaton parsed = fa::Automaton::parse(in, format);
+      EXPECT_EQ(fa.countSymbols(), parsed.countSymbols());
+      EXPECT_EQ(fa.countTransitions(), parsed.countTransitions());
+      EXPECT_TRUE(parsed.isEquivalentTo(fa));
+    }
+  }
+}
+
+TEST(EmitCpp, Switch) {
+  std::ostringstream out;
+  createPrintExample().emitCpp(out);
+  std::string code = out.str();
+  EXPECT_NE(std::string::npos, code.find("#include <string_view>"));
+  EXPECT_NE(std::string::npos, code.find("inline bool match(std::string_view word) {"));
+  EXPECT_NE(std::string::npos, code.find("      case 0:\n        switch (letter) {\n          case 'a': state = 1; break;\n          case 'b': state = 1; break;\n          default: return false;\n"));
+  EXPECT_NE(std::string::npos, code.find("      case 1:\n        switch (letter) {\n          case 'a': state = 0; break;\n          default: return false;\n"));
+  EXPECT_NE(std::string::npos, code.find("  switch (state) {\n    case 1:\n      return true;\n"));
+  EXPECT_EQ(std::string::npos, code.find("case 2"));
+}
+
+TEST(EmitCpp, Tables) {
+  fa::EmitOptions options;
+  options.style = fa::EmitOptions::Style::Tables;
+  options.functionName = "isKeyword";
+  options.namespaceName = "generated";
+  std::ostringstream out;
+  createPrintExample().emitCpp(out, options);
+  std::string code = out.str();
+  EXPECT_NE(std::string::npos, code.find("namespace generated {"));
+  EXPECT_NE(std::string::npos, code.find("  constexpr short isKeyword_next[2][3] = {\n    {-1, 1, 1},\n    {-1, 0, -1},\n  };"));
+  EXPECT_NE(std::string::npos, code.find("  constexpr bool isKeyword_finals[2] = {\n    false,true,\n  };"));
+  EXPECT_NE(std::string::npos, code.find("  inline bool isKeyword(std::string_view word) {"));
+}
+
+TEST(EmitCpp, EmptyLanguage) {
+  fa::Automaton fa;
+  fa.addSymbol('a');
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  fa.addTransition(1, 'a', 0);
+  std::ostringstream out;
+  fa.emitCpp(out);
+  EXPECT_NE(std::string::npos, out.str().find("inline bool match(std::string_view) {\n  return false;\n}\n"));
+}
+
+namespace {
+  // Hexadecimal numbers like 0x1F
+  constexpr auto StaticHex = [] {
+    fa::StaticDfa<3, 18> dfa("0123456789ABCDEFx_");
+    dfa.addTransition(0, '0', 1);
+    dfa.addTransition(1, 'x', 2);
+    for (char alpha : std::string_view("0123456789ABCDEF")) {
+      dfa.addTransition(2, alpha, 2);
+    }
+    dfa.setStateFinal(2);
+    return dfa;
+  }();
+
+  static_assert(StaticHex.match("0x"));
+  static_assert(StaticHex.match("0x1F"));
+  static_assert(!StaticHex.match("0x1g"));
+  static_assert(!StaticHex.match("1x"));
+  static_assert(!StaticHex.match(""));
+}
+
+TEST(StaticDfa, Match) {
+  EXPECT_TRUE(StaticHex.match("0xCAFE"));
+  EXPECT_FALSE(StaticHex.match("0x_"));
+  EXPECT_FALSE(StaticHex.match("0x\xff"));
+  EXPECT_EQ(3u, StaticHex.countStates());
+  EXPECT_EQ(18u, StaticHex.countSymbols());
+  EXPECT_EQ(2, StaticHex.getTransition(1, 'x'));
+  EXPECT_EQ(-1, StaticHex.getTransition(0, 'x'));
+  EXPECT_TRUE(StaticHex.isStateFinal(2));
+}
+
+TEST(StaticDfa, Errors) {
+  using Dfa = fa::StaticDfa<2, 2>;
+  EXPECT_THROW(Dfa("a"), std::invalid_argument);
+  EXPECT_THROW(Dfa("aa"), std::invalid_argument);
+  EXPECT_THROW(Dfa("a "), std::invalid_argument);
+  EXPECT_THROW(Dfa(std::string_view("a\0", 2)), std::invalid_argument);
+  EXPECT_THROW(Dfa("a\xe9"), std::invalid_argument);
+  Dfa dfa("ab");
+  EXPECT_THROW(dfa.addTransition(0, 'c', 1), std::invalid_argument);
+  EXPECT_THROW(dfa.addTransition(0, 'a', 2), std::invalid_argument);
+  dfa.addTransition(0, 'a', 1);
+  dfa.addTransition(0, 'a', 1);
+  EXPECT_THROW(dfa.addTransition(0, 'a', 0), std::invalid_argument);
+  EXPECT_THROW(dfa.setStateFinal(-1), std::invalid_argument);
+}
+
+TEST(StaticDfa, ToAutomaton) {
+  fa::Automaton fa = StaticHex.toAutomaton();
+  EXPECT_TRUE(fa.isValid());
+  EXPECT_TRUE(fa.isDeterministic());
+  EXPECT_EQ(3u, fa.countStates());
+  EXPECT_EQ(18u, fa.countSymbols());
+  EXPECT_TRUE(fa.match("0x1F"));
+  EXPECT_FALSE(fa.match("0x_"));
+}
+
+TEST(Statistics, Deterministic) {
+  fa::Automaton fa = createNthFromEnd(3);
+  fa::Statistics statistics;
+  {
+    fa::StatisticsScope scope(statistics);
+    fa::Automaton deterministic = fa::Automaton::createDeterministic(fa);
+    EXPECT_EQ(8u, deterministic.countStates());
+  }
+  EXPECT_EQ(1u, statistics.operations);
+  EXPECT_EQ(8u, statistics.subsetsCreated);
+  EXPECT_EQ(8u, statistics.statesExplored);
+  EXPECT_EQ(16u, statistics.transitionsExplored);
+  EXPECT_EQ(0u, statistics.productPairs);
+  EXPECT_EQ(0u, statistics.refinementRounds);
+  EXPECT_LT(0u, statistics.peakBytes);
+
+  fa::Automaton::createDeterministic(fa);
+  EXPECT_EQ(1u, statistics.operations);
+  EXPECT_EQ(8u, statistics.subsetsCreated);
+}
+
+TEST(Statistics, NestedOperationsCountOnce) {
+  fa::Statistics statistics;
+  fa::StatisticsScope scope(statistics);
+  fa::Automaton minimal = fa::Automaton::createMinimalMoore(createNthFromEnd(3));
+  EXPECT_EQ(8u, minimal.countStates());
+  EXPECT_EQ(1u, statistics.operations);
+  EXPECT_EQ(8u, statistics.subsetsCreated);
+  EXPECT_LE(1u, statistics.refinementRounds);
+
+  fa::Statistics inner;
+  {
+    fa::StatisticsScope innerScope(inner);
+    EXPECT_TRUE(createNthFromEnd(2).isIncludedIn(createNthFromEnd(2)));
+  }
+  EXPECT_EQ(1u, inner.operations);
+  EXPECT_LT(0u, inner.productPairs);
+  EXPECT_EQ(1u, statistics.operations);
+}
+
+TEST(Statistics, Equivalence) {
+  fa::Statistics statistics;
+  fa::StatisticsScope scope(statistics);
+  EXPECT_FALSE(createNthFromEnd(2).isEquivalentTo(createNthFromEnd(3)));
+  EXPECT_EQ(1u, statistics.operations);
+  EXPECT_LT(0u, statistics.subsetsCreated);
+  EXPECT_LT(0u, statistics.productPairs);
+}
+
+TEST(Statistics, ParallelCountsInTheCallingThread) {
+  fa::Automaton fa = createNthFromEnd(5);
+  fa::Statistics statistics;
+  {
+    fa::StatisticsScope scope(statistics);
+    fa::Automaton::createDeterministicParallel(fa, 4);
+  }
+  EXPECT_EQ(1u, statistics.operations);
+  EXPECT_EQ(32u, statistics.subsetsCreated);
+  EXPECT_EQ(32u, statistics.statesExplored);
+  EXPECT_EQ(64u, statistics.transitionsExplored);
+}
+
+TEST(MemoryUsage, Parts) {
+  fa::Automaton empty;
+  fa::MemoryUsage none = empty.memoryUsage();
+  EXPECT_EQ(0u, none.arcs);
+  EXPECT_EQ(0u, none.alphabet);
+  EXPECT_LE(sizeof(fa::Automaton), none.states);
+
+  fa::Automaton fa = createRandomAutomaton(50, 3);
+  fa::MemoryUsage usage = fa.memoryUsage();
+  EXPECT_LT(none.states, usage.states);
+  EXPECT_LE(fa.countTransitions() * 2 * sizeof(int), usage.arcs);
+  EXPECT_LE(3u * (sizeof(char) + 1), usage.alphabet);
+  EXPECT_LE(fa.countStates() * 2 * sizeof(int), usage.indexes);
+  EXPECT_LT(0u, usage.caches);
+  EXPECT_EQ(usage.states + usage.arcs + usage.alphabet + usage.indexes + usage.caches, usage.total());
+}
+
+TEST(MemoryUsage, GrowsWithTheAutomaton) {
+  EXPECT_LT(createRandomAutomaton(10, 1).memoryUsage().total(), createRandomAutomaton(200, 1).memoryUsage().total());
+}
+
+TEST(MemoryUsage, ShrinkToFitAfterRemovingStates) {
+  fa::Automaton fa = createRandomAutomaton(300, 5);
+  for(int state = 1; state < 300; state++){
+    fa.removeState(state * 7);
+  }
+  fa::MemoryUsage before = fa.memoryUsage();
+  fa.shrinkToFit();
+  fa::MemoryUsage after = fa.memoryUsage();
+  EXPECT_LT(after.total(), before.total());
+  EXPECT_LT(after.states, before.states);
+  EXPECT_LE(after.indexes, before.indexes);
+  EXPECT_EQ(1u, fa.countStates());
+  EXPECT_TRUE(fa.hasState(0));
+  EXPECT_TRUE(fa.isStateInitial(0));
+}
+
+TEST(TokenAutomaton, Edition) {
+  fa::TokenAutomaton fa;
+  EXPECT_FALSE(fa.isValid());
+  EXPECT_TRUE(fa.addSymbol(4999));
+  EXPECT_TRUE(fa.addSymbol(17));
+  EXPECT_FALSE(fa.addSymbol(4999));
+  EXPECT_TRUE(fa.addState(0));
+  EXPECT_TRUE(fa.addState(10));
+  EXPECT_FALSE(fa.addState(-1));
+  EXPECT_TRUE(fa.isValid());
+  EXPECT_EQ(2u, fa.countSymbols());
+  EXPECT_TRUE(fa.addTransition(0, 4999, 10));
+  EXPECT_TRUE(fa.addTransition(0, 17, 10));
+  EXPECT_TRUE(fa.addTransition(0, 17, 0));
+  EXPECT_FALSE(fa.addTransition(0, 17, 0));
+  EXPECT_FALSE(fa.addTransition(0, 18, 0));
+  EXPECT_FALSE(fa.addTransition(0, 17, 1));
+  EXPECT_EQ(3u, fa.countTransitions());
+  EXPECT_TRUE(fa.hasTransition(0, 17, 10));
+  EXPECT_TRUE(fa.removeTransition(0, 17, 10));
+  EXPECT_FALSE(fa.removeTransition(0, 17, 10));
+  EXPECT_FALSE(fa.hasTransition(0, 17, 10));
+  EXPECT_EQ(2u, fa.countTransitions());
+  fa.setStateInitial(0);
+  fa.setStateFinal(10);
+  EXPECT_TRUE(fa.isStateInitial(0));
+  EXPECT_TRUE(fa.isStateFinal(10));
+  EXPECT_TRUE(fa.isDeterministic());
+  EXPECT_TRUE(fa.match({17, 17, 4999}));
+  EXPECT_FALSE(fa.match({17}));
+  EXPECT_FALSE(fa.match({4999, 17}));
+}
+
+TEST(TokenAutomaton, LargeAlphabet) {
+  // The words ending with the symbols 4999 then 17, over 5000 symbols
+  fa::TokenAutomaton fa;
+  for(fa::TokenAutomaton::Symbol symbol = 0; symbol < 5000; symbol++){
+    fa.addSymbol(symbol);
+  }
+  fa.addState(0);
+  fa.addState(1);
+  fa.addState(2);
+  fa.setStateInitial(0);
+  fa.setStateFinal(2);
+  for(fa::TokenAutomaton::Symbol symbol = 0; symbol < 5000; symbol++){
+    fa.addTransition(0, symbol, 0);
+  }
+  fa.addTransition(0, 4999, 1);
+  fa.addTransition(1, 17, 2);
+  EXPECT_FALSE(fa.isDeterministic());
+
+  fa::TokenAutomaton deterministic = fa::TokenAutomaton::createDeterministic(fa);
+  EXPECT_TRUE(deterministic.isDeterministic());
+  EXPECT_EQ(3u, deterministic.countStates());
+  EXPECT_EQ(15000u, deterministic.countTransitions());
+  EXPECT_TRUE(deterministic.match({3, 4999, 17}));
+  EXPECT_FALSE(deterministic.match({4999, 17, 3}));
+
+  fa::TokenAutomaton minimal = fa::TokenAutomaton::createMinimal(fa);
+  EXPECT_EQ(3u, minimal.countStates());
+  EXPECT_TRUE(minimal.isStateInitial(0));
+  EXPECT_TRUE(minimal.match({4999, 4999, 17}));
+  EXPECT_FALSE(minimal.match({4999, 16}));
+}
+
+TEST(TokenAutomaton, SameLanguageAsAutomaton) {
+  std::mt19937 generator(11);
+  for(unsigned seed = 0; seed < 10; seed++){
+    fa::Automaton fa = createRandomAutomaton(12, seed);
+    fa::TokenAutomaton tokens = fa::TokenAutomaton::fromAutomaton(fa);
+    EXPECT_EQ(fa.countStates(), tokens.countStates());
+    EXPECT_EQ(fa.countTransitions(), tokens.countTransitions());
+    fa::TokenAutomaton deterministic = fa::TokenAutomaton::createDeterministic(tokens);
+    fa::TokenAutomaton minimal = fa::TokenAutomaton::createMinimal(tokens);
+    EXPECT_TRUE(deterministic.isDeterministic());
+    EXPECT_TRUE(minimal.isDeterministic());
+    EXPECT_EQ(minimal.countStates(), fa::TokenAutomaton::createMinimal(minimal).countStates());
+    EXPECT_EQ(fa.isLanguageEmpty(), tokens.isLanguageEmpty());
+    for(int i = 0; i < 200; i++){
+      std::string word;
+      std::vector<fa::TokenAutomaton::Symbol> symbols;
+      for(int length = generator() % 8; length > 0; length--){
+        word.push_back("abc"[generator() % 3]);
+        symbols.push_back((unsigned char)word.back());
+      }
+      bool expected = matchBySets(fa, word);
+      EXPECT_EQ(expected, tokens.match(symbols));
+      EXPECT_EQ(expected, deterministic.match(symbols));
+      EXPECT_EQ(expected, minimal.match(symbols));
+    }
+  }
+}
+
+TEST(TokenAutomaton, Product) {
+  std::mt19937 generator(5);
+  fa::TokenAutomaton lhs = fa::TokenAutomaton::fromAutomaton(createRandomAutomaton(10, 1));
+  fa::TokenAutomaton rhs = fa::TokenAutomaton::fromAutomaton(createRandomAutomaton(10, 2));
+  fa::TokenAutomaton product = fa::TokenAutomaton::createProduct(lhs, rhs);
+  EXPECT_TRUE(product.isValid());
+  for(int i = 0; i < 500; i++){
+    std::vector<fa::TokenAutomaton::Symbol> word;
+    for(int length = generator() % 8; length > 0; length--){
+      word.push_back("abc"[generator() % 3]);
+    }
+    EXPECT_EQ(lhs.match(word) && rhs.match(word), product.match(word));
+  }
+
+  fa::TokenAutomaton other;
+  other.addSymbol(1000);
+  other.addState(0);
+  other.setStateInitial(0);
+  other.setStateFinal(0);
+  fa::TokenAutomaton empty = fa::TokenAutomaton::createProduct(lhs, other);
+  EXPECT_TRUE(empty.isValid());
+  EXPECT_EQ(0u, empty.countTransitions());
+  EXPECT_EQ(lhs.match({}), empty.match({}));
+}
+
+static std::string encodeUtf8(char32_t codePoint) {
+  std::string bytes;
+  if(codePoint < 0x80){
+    bytes.push_back((char)codePoint);
+  }else if(codePoint < 0x800){
+    bytes.push_back((char)(0xC0 | codePoint >> 6));
+    bytes.push_back((char)(0x80 | (codePoint & 0x3F)));
+  }else if(codePoint < 0x10000){
+    bytes.push_back((char)(0xE0 | codePoint >> 12));
+    bytes.push_back((char)(0x80 | (codePoint >> 6 & 0x3F)));
+    bytes.push_back((char)(0x80 | (codePoint & 0x3F)));
+  }else{
+    bytes.push_back((char)(0xF0 | codePoint >> 18));
+    bytes.push_back((char)(0x80 | (codePoint >> 12 & 0x3F)));
+    bytes.push_back((char)(0x80 | (codePoint >> 6 & 0x3F)));
+    bytes.push_back((char)(0x80 | (codePoint & 0x3F)));
+  }
+  return bytes;
+}
+
+// Decodes the text, and checks that encoding the code points gives back the same bytes
+static bool isValidUtf8ByDecoding(const std::string& bytes) {
+  std::string encoded;
+  for(std::size_t i = 0; i < bytes.size(); ){
+    unsigned char lead = bytes[i];
+    std::size_t length = lead < 0x80 ? 1 : lead >= 0xC0 && lead < 0xE0 ? 2 : lead >= 0xE0 && lead < 0xF0 ? 3 : lead >= 0xF0 && lead < 0xF8 ? 4 : 0;
+    if(length == 0 || i + length > bytes.size()){
+      return false;
+    }
+    char32_t codePoint = length == 1 ? lead : lead & (0x7F >> length);
+    for(std::size_t k = 1; k < length; k++){
+      codePoint = codePoint << 6 | (bytes[i + k] & 0x3F);
+    }
+    if(codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF)){
+      return false;
+    }
+    encoded += encodeUtf8(codePoint);
+    i += length;
+  }
+  return encoded == bytes;
+}
+
+TEST(Utf8, Validation) {
+  EXPECT_TRUE(fa::isValidUtf8(""));
+  EXPECT_TRUE(fa::isValidUtf8("hello"));
+  EXPECT_TRUE(fa::isValidUtf8("\xc3\xa9t\xc3\xa9 \xe6\x97\xa5\xe6\x9c\xac \xf0\x9f\x98\x80"));
+  EXPECT_TRUE(fa::isValidUtf8("\xf4\x8f\xbf\xbf"));
+  EXPECT_FALSE(fa::isValidUtf8("\xc0\x80"));
+  EXPECT_FALSE(fa::isValidUtf8("\xe0\x9f\xbf"));
+  EXPECT_FALSE(fa::isValidUtf8("\xed\xa0\x80"));
+  EXPECT_FALSE(fa::isValidUtf8("\xf4\x90\x80\x80"));
+  EXPECT_FALSE(fa::isValidUtf8("\xf8\x88\x80\x80\x80"));
+  EXPECT_FALSE(fa::isValidUtf8("\x80"));
+  EXPECT_FALSE(fa::isValidUtf8("a\xe6\x97"));
+  EXPECT_FALSE(fa::isValidUtf8(std::string(31, 'a') + "\xf0\x9f\x98"));
+  EXPECT_FALSE(fa::isValidUtf8(std::string(32, 'a') + "\xf0"));
+}
+
+TEST(Utf8, ValidationOfRandomTexts) {
+  std::mt19937 generator(3);
+  const char32_t samples[] = {'a', 0x7F, 0x80, 0x7FF, 0x800, 0xD7FF, 0xE000, 0xFFFF, 0x10000, 0x10FFFF, 0x4E2D, 0x1F600};
+  for(int i = 0; i < 2000; i++){
+    std::string text;
+    for(int length = generator() % 40; length > 0; length--){
+      text += encodeUtf8(samples[generator() % 12]);
+    }
+    if(!text.empty() && generator() % 2 == 0){
+      text[generator() % text.size()] = (char)(generator() % 256);
+    }
+    EXPECT_EQ(isValidUtf8ByDecoding(text), fa::isValidUtf8(text)) << i;
+  }
+}
+
+TEST(Utf8, CompileRanges) {
+  // Words of one or more code points, each one being in one of the ranges
+  std::vector<fa::CodePointRange> ranges = {{'a', 'z'}, {0x391, 0x3C9}, {0x4E00, 0x9FFF}, {0x1F600, 0x1F64F}};
+  fa::TokenAutomaton fa;
+  for(fa::TokenAutomaton::Symbol symbol = 0; symbol < ranges.size(); symbol++){
+    fa.addSymbol(symbol);
+  }
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  for(fa::TokenAutomaton::Symbol symbol = 0; symbol < ranges.size(); symbol++){
+    fa.addTransition(0, symbol, 1);
+    fa.addTransition(1, symbol, 1);
+  }
+  fa::TokenAutomaton bytes = fa::TokenAutomaton::createUtf8(fa, ranges);
+  EXPECT_TRUE(bytes.matchBytes("abc"));
+  EXPECT_TRUE(bytes.matchBytes("\xce\xb1\xce\xb2\xe4\xb8\xad\xf0\x9f\x98\x80z"));
+  EXPECT_FALSE(bytes.matchBytes(""));
+  EXPECT_FALSE(bytes.matchBytes("A"));
+  EXPECT_FALSE(bytes.matchBytes("\xe4\xb8"));
+
+  std::mt19937 generator(8);
+  for(int i = 0; i < 3000; i++){
+    char32_t codePoint = generator() % 0x110000;
+    if(codePoint >= 0xD800 && codePoint <= 0xDFFF){
+      continue;
+    }
+    bool expected = false;
+    for(auto const &range : ranges){
+      expected = expected || (codePoint >= range.first && codePoint <= range.last);
+    }
+    EXPECT_EQ(expected, bytes.matchBytes(encodeUtf8(codePoint))) << (std::uint32_t)codePoint;
+  }
+  fa::TokenAutomaton minimal = fa::TokenAutomaton::createMinimal(bytes);
+  EXPECT_TRUE(minimal.matchBytes("\xf0\x9f\x99\x8f"));
+  EXPECT_FALSE(minimal.matchBytes("\xf0\x9f\x99\x90"));
+}
+
+TEST(Utf8, ByteMatcher) {
+  // The table of 256 columns agrees with the sets of states of matchBytes()
+  std::vector<fa::CodePointRange> ranges = {{'a', 'z'}, {0x391, 0x3C9}, {0x1F600, 0x1F64F}};
+  fa::TokenAutomaton fa;
+  for(fa::TokenAutomaton::Symbol symbol = 0; symbol < ranges.size(); symbol++){
+    fa.addSymbol(symbol);
+  }
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  for(fa::TokenAutomaton::Symbol symbol = 0; symbol < ranges.size(); symbol++){
+    fa.addTransition(0, symbol, 1);
+    fa.addTransition(1, symbol, 1);
+  }
+  fa::TokenAutomaton bytes = fa::TokenAutomaton::createUtf8(fa, ranges);
+  fa::ByteMatcher matcher(bytes);
+  EXPECT_TRUE(matcher.match("abc"));
+  EXPECT_TRUE(matcher.match("\xce\xb1\xf0\x9f\x98\x80z"));
+  EXPECT_FALSE(matcher.match(""));
+  EXPECT_FALSE(matcher.match("\xce"));
+
+  std::mt19937 generator(9);
+  for(int i = 0; i < 2000; i++){
+    std::string text;
+    std::size_t length = generator() % 4;
+    for(std::size_t j = 0; j < length; j++){
+      char32_t codePoint = generator() % 2 == 0 ? 'a' + generator() % 30 : generator() % 0x20000;
+      if(codePoint >= 0xD800 && codePoint <= 0xDFFF){
+        codePoint = 'b';
+      }
+      text += encodeUtf8(codePoint);
+    }
+    if(!text.empty() && generator() % 4 == 0){
+      text[generator() % text.size()] = (char)(generator() % 256);
+    }
+    EXPECT_EQ(bytes.matchBytes(text), matcher.match(text)) << i;
+  }
+
+  fa::TokenAutomaton empty;
+  empty.addSymbol('a');
+  empty.addState(0);
+  fa::ByteMatcher none(empty);
+  EXPECT_FALSE(none.match(""));
+  EXPECT_FALSE(none.match("a"));
+}
+
+TEST(Utf8, SharedSuffixes) {
+  // Every code point of three bytes : the continuation bytes need four states only
+  fa::TokenAutomaton fa;
+  fa.addSymbol(0);
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  fa.addTransition(0, 0, 1);
+  fa::TokenAutomaton bytes = fa::TokenAutomaton::createUtf8(fa, {{0x800, 0xFFFF}});
+  EXPECT_EQ(6u, bytes.countStates());
+  EXPECT_TRUE(bytes.isDeterministic());
+  EXPECT_TRUE(bytes.matchBytes("\xe0\xa0\x80"));
+  EXPECT_TRUE(bytes.matchBytes("\xef\xbf\xbf"));
+  EXPECT_FALSE(bytes.matchBytes("\xed\xa0\x80"));
+  EXPECT_FALSE(bytes.matchBytes("\xe0\x9f\xbf"));
+
+  EXPECT_THROW(fa::TokenAutomaton::createUtf8(fa, {}), std::invalid_argument);
+  EXPECT_THROW(fa::TokenAutomaton::createUtf8(fa, {{0x110000, 0x110001}}), std::invalid_argument);
+  EXPECT_THROW(fa::TokenAutomaton::createUtf8(fa, {{0xD800, 0xDFFF}}), std::invalid_argument);
+  EXPECT_NO_THROW(fa::TokenAutomaton::createUtf8(fa, {{0xD7FF, 0xE000}}));
+}
+
+TEST(SymbolSet, Operations) {
+  fa::SymbolSet set = fa::SymbolSet::fromIntervals({{10, 20}, {21, 25}, {5, 12}, {40, 30}, {100, 100}});
+  ASSERT_EQ(2u, set.getIntervals().size());
+  EXPECT_EQ(5u, set.getIntervals()[0].first);
+  EXPECT_EQ(25u, set.getIntervals()[0].last);
+  EXPECT_EQ(22u, set.countSymbols());
+  EXPECT_TRUE(set.contains(5));
+  EXPECT_TRUE(set.contains(100));
+  EXPECT_FALSE(set.contains(26));
+  EXPECT_FALSE(set.contains(4));
+
+  fa::SymbolSet complement = set.complement();
+  EXPECT_EQ((std::uint64_t(1) << 32) - 22, complement.countSymbols());
+  EXPECT_TRUE(complement.intersectionWith(set).isEmpty());
+  EXPECT_EQ(fa::SymbolSet::all(), complement.unionWith(set));
+  EXPECT_TRUE(fa::SymbolSet::all().complement().isEmpty());
+  EXPECT_EQ(fa::SymbolSet::all(), fa::SymbolSet().complement());
+  EXPECT_EQ(fa::SymbolSet::range(20, 25).unionWith(fa::SymbolSet::single(100)), set.intersectionWith(fa::SymbolSet::range(20, 4000000000u)));
+  EXPECT_TRUE(fa::SymbolSet::range(3, 2).isEmpty());
+}
+
+TEST(SymbolicAutomaton, AnySymbolExcept) {
+  // The words containing x, with a transition for all the symbols except x
+  fa::SymbolicAutomaton fa;
+  fa.addState(0);
+  fa.addState(1);
+  fa.setStateInitial(0);
+  fa.setStateFinal(1);
+  EXPECT_TRUE(fa.addTransition(0, fa::SymbolSet::single('x').complement(), 0));
+  EXPECT_TRUE(fa.addTransition(0, fa::SymbolSet::single('x'), 1));
+  EXPECT_TRUE(fa.addTransition(1, fa::SymbolSet::range(0, 99), 1));
+  EXPECT_TRUE(fa.addTransition(1, fa::SymbolSet::range(100, 0xFFFFFFFF), 1));
+  EXPECT_FALSE(fa.addTransition(1, fa::SymbolSet(), 0));
+  EXPECT_FALSE(fa.addTransition(1, fa::SymbolSet::all(), 2));
+  EXPECT_EQ(3u, fa.countTransitions());
+  EXPECT_EQ(fa::SymbolSet::all(), fa.getTransition(1, 1));
+  EXPECT_TRUE(fa.isDeterministic());
+  EXPECT_TRUE(fa.isComplete());
+  EXPECT_TRUE(fa.match({'a', 70000, 'x', 'b'}));
+  EXPECT_FALSE(fa.match({'a', 70000}));
+
+  fa::SymbolicAutomaton onlyX;
+  onlyX.addState(0);
+  onlyX.addState(1);
+  onlyX.setStateInitial(0);
+  onlyX.setStateFinal(1);
+  onlyX.addTransition(0, fa::SymbolSet::single('x'), 1);
+  EXPECT_FALSE(onlyX.isComplete());
+  fa::SymbolicAutomaton complete = fa::SymbolicAutomaton::createComplete(onlyX);
+  EXPECT_TRUE(complete.isComplete());
+  EXPECT_EQ(3u, complete.countStates());
+  EXPECT_EQ(4u, complete.countTransitions());
+  EXPECT_TRUE(complete.match({'x'}));
+  EXPECT_FALSE(complete.match({'x', 'x'}));
+}
+
+TEST(SymbolicAutomaton, DeterministicOnMinterms) {
+  // The words whose second to last symbol is a lowercase letter, or that end with a digit then anything
+  fa::SymbolicAutomaton fa;
+  for(int state = 0; state < 4; state++){
+    fa.addState(state);
+  }
+  fa.setStateInitial(0);
+  fa.setStateFinal(2);
+  fa.addTransition(0, fa::SymbolSet::all(), 0);
+  fa.addTransition(0, fa::SymbolSet::range('a', 'z'), 1);
+  fa.addTransition(1, fa::SymbolSet::all(), 2);
+  fa.addTransition(0, fa::SymbolSet::range('0', '9'), 3);
+  fa.addTransition(3, fa::SymbolSet::range('a', 'f'), 2);
+  EXPECT_FALSE(fa.isDeterministic());
+
+  fa::SymbolicAutomaton deterministic = fa::SymbolicAutomaton::createDeterministic(fa);
+  fa::SymbolicAutomaton minimal = fa::SymbolicAutomaton::createMinimal(fa);
+  EXPECT_TRUE(deterministic.isDeterministic());
+  EXPECT_TRUE(minimal.isDeterministic());
+  EXPECT_LE(minimal.countStates(), deterministic.countStates());
+  EXPECT_LT(deterministic.countTransitions(), 30u);
+  EXPECT_TRUE(minimal.isComplete());
+
+  std::mt19937 generator(4);
+  const fa::SymbolicAutomaton::Symbol samples[] = {0, '0', '9', 'a', 'f', 'g', 'z', '{', 0xFFFFFFFF};
+  for(int i = 0; i < 1000; i++){
+    std::vector<fa::SymbolicAutomaton::Symbol> word;
+    for(int length = generator() % 6; length > 0; length--){
+      word.push_back(samples[generator() % 9]);
+    }
+    bool expected = fa.match(word);
+    EXPECT_EQ(expected, deterministic.match(word));
+    EXPECT_EQ(expected, minimal.match(word));
+  }
+}
+
+TEST(SymbolicAutomaton, SameAsTokenAutomaton) {
+  std::mt19937 generator(12);
+  for(unsigned seed = 0; seed < 10; seed++){
+    fa::Automaton fa = createRandomAutomaton(12, seed);
+    fa::SymbolicAutomaton symbolic = fa::SymbolicAutomaton::fromAutomaton(fa);
+    fa::TokenAutomaton tokens = fa::TokenAutomaton::fromAutomaton(fa);
+    fa::SymbolicAutomaton minimal = fa::SymbolicAutomaton::createMinimal(symbolic);
+    EXPECT_EQ(fa::TokenAutomaton::createMinimal(tokens).countStates(), minimal.countStates());
+    EXPECT_EQ(fa.isLanguageEmpty(), symbolic.isLanguageEmpty());
+    fa::SymbolicAutomaton product = fa::SymbolicAutomaton::createProduct(symbolic, fa::SymbolicAutomaton::fromAutomaton(createRandomAutomaton(8, seed + 100)));
+    fa::TokenAutomaton other = fa::TokenAutomaton::fromAutomaton(createRandomAutomaton(8, seed + 100));
+    for(int i = 0; i < 200; i++){
+      std::vector<fa::SymbolicAutomaton::Symbol> word;
+      for(int length = generator() % 8; length > 0; length--){
+        word.push_back("abc"[generator() % 3]);
+      }
+      EXPECT_EQ(tokens.match(word), symbolic.match(word));
+      EXPECT_EQ(tokens.match(word), minimal.match(word));
+      EXPECT_EQ(tokens.match(word) && other.match(word), product.match(word));
+    }
+  }
+}
+
+TEST(AutomatonSnapshot, CopiesShareTheStorage) {
+  fa::Automaton fa = createNthFromEnd(3);
+  fa::AutomatonSnapshot snapshot(fa);
+  fa::AutomatonSnapshot copy = snapshot;
+  EXPECT_EQ(2u, snapshot.countShares());
+  EXPECT_EQ(&snapshot.get(), &copy.get());
+  EXPECT_EQ(&*copy, copy.operator->());
+  EXPECT_EQ(4u, copy->countStates());
+  EXPECT_TRUE(copy->match("baab"));
+
+  fa.addTransition(3, 'a', 3);
+  EXPECT_FALSE(snapshot->hasTransition(3, 'a', 3));
+
+  fa::AutomatonSnapshot empty;
+  EXPECT_EQ(0u, empty->countStates());
+  EXPECT_EQ(1u, empty.countShares());
+}
+
+TEST(AutomatonSnapshot, BackToAutomaton) {
+  fa::AutomatonSnapshot snapshot(createNthFromEnd(3));
+  fa::AutomatonSnapshot copy = snapshot;
+
+  fa::Automaton shared = std::move(copy).toAutomaton();
+  EXPECT_EQ(0u, copy->countStates());
+  EXPECT_EQ(1u, snapshot.countShares());
+  shared.removeState(3);
+  EXPECT_EQ(3u, shared.countStates());
+  EXPECT_EQ(4u, snapshot->countStates());
+
+  fa::Automaton mutableCopy = snapshot.toAutomaton();
+  mutableCopy.setStateFinal(0);
+  EXPECT_FALSE(snapshot->isStateFinal(0));
+
+  fa::Automaton taken = std::move(snapshot).toAutomaton();
+  EXPECT_EQ(4u, taken.countStates());
+  EXPECT_TRUE(taken.match("aaa"));
+  EXPECT_EQ(0u, snapshot->countStates());
+}
+
+TEST(AutomatonSnapshot, Compact) {
+  fa::Automaton fa = createRandomAutomaton(300, 5);
+  for(int state = 1; state < 300; state++){
+    fa.removeState(state * 7);
+  }
+  std::size_t before = fa.memoryUsage().total();
+  fa::AutomatonSnapshot snapshot(std::move(fa));
+  EXPECT_LT(snapshot->memoryUsage().total(), before);
+}
+
+TEST(AutomatonSnapshot, ConcurrentQueries) {
+  fa::AutomatonSnapshot snapshot(createRandomAutomaton(40, 9));
+  std::vector<std::string> words;
+  std::mt19937 generator(2);
+  for(int i = 0; i < 300; i++){
+    std::string word;
+    for(int length = generator() % 10; length > 0; length--){
+      word.push_back("abc"[generator() % 3]);
+    }
+    words.push_back(word);
+  }
+  std::vector<bool> expected;
+  for(auto const &word : words){
+    expected.push_back(snapshot->match(word));
+  }
+  std::atomic<int> mismatches(0);
+  std::vector<std::thread> threads;
+  for(int t = 0; t < 8; t++){
+    threads.emplace_back([&, copy = snapshot](){
+      for(int round = 0; round < 5; round++){
+        for(std::size_t i = 0; i < words.size(); i++){
+          if(copy->match(words[i]) != expected[i]){
+            mismatches++;
+          }
+        }
+        if(copy->isLanguageEmpty() != snapshot->isLanguageEmpty() || copy->countTransitions() != snapshot->countTransitions()){
+          mismatches++;
+        }
+      }
+    });
+  }
+  for(auto &thread : threads){
+    thread.join();
+  }
+  EXPECT_EQ(0, mismatches.load());
+}
+
+TEST(SymbolicAutomaton, MinimalChain) {
+  // Each state has its own symbol, so there are as many minterms as states
+  fa::SymbolicAutomaton fa;
+  const int length = 3000;
+  for(int state = 0; state <= length; state++){
+    fa.addState(state);
+  }
+  fa.setStateInitial(0);
+  fa.setStateFinal(length);
+  for(int state = 0; state < length; state++){
+    fa.addTransition(state, fa::SymbolSet::single(state), state + 1);
+  }
+  fa::SymbolicAutomaton minimal = fa::SymbolicAutomaton::createMinimal(fa);
+  EXPECT_EQ((std::size_t)length + 1, minimal.countStates());
+  EXPECT_EQ((std::size_t)length, minimal.countTransitions());
+
+  fa::Limits limits;
+  limits.maxBytes = 100000;
+  EXPECT_THROW(fa::SymbolicAutomaton::createMinimal(fa, limits), fa::LimitExceeded);
+}
+
 // MAIN
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);